@@ -30,11 +30,122 @@ constexpr double PA_per_M       = 11.3;
 /// ft altitude diff per hPa change
 constexpr double FT_per_HPA     = (100/PA_per_M)/XPMP2::M_per_FT;
 
-/// Minimum time expected between two position to allow for meaningful interpolation
-constexpr auto MIN_TS_DIFF = std::chrono::milliseconds(100);
+/// Meters per second per knot
+constexpr double MS_per_KT      = 1852.0 / 3600.0;
+/// Meters per second per feet per minute
+constexpr double MS_per_FPM     = XPMP2::M_per_FT / 60.0;
+/// Mean earth radius [m]
+constexpr double EARTH_RADIUS_M = 6371000.0;
+
+/// Absolute minimum time between two positions, even if configured lower or decimating to a high frame rate
+constexpr auto MIN_TS_DIFF = std::chrono::milliseconds(1);
 
 /// Maximum `f` factor for non-location values during interpolation, like attitude, config
 constexpr float MAX_F = 1.25f;
 
 /// How long does the moment of touch down last? [seconds]
 constexpr float TOUCH_DOWN_TIME = 0.5f;
+
+/// Dead reckoning: maximum turn extrapolated from the track rate, afterwards the plane continues straight [deg]
+constexpr float DR_MAX_TURN = 90.0f;
+
+/// Jitter buffer: smoothing factor for the mean required delay
+constexpr double JITTER_ALPHA = 0.125;
+/// Jitter buffer: smoothing factor for the mean deviation of the required delay
+constexpr double JITTER_BETA = 0.25;
+/// Jitter buffer: standard deviation per mean deviation (for normally distributed delays)
+constexpr double JITTER_SIGMA_PER_DEV = 1.25;
+/// Jitter buffer: the delay shrinks by at most this share of the time passed in the data, so that display stays in order
+constexpr double JITTER_MAX_SHRINK = 0.1;
+
+/// Track filter: gap in data after which the filter restarts [s]
+constexpr double FILTER_MAX_GAP = 30.0;
+/// Track filter: minimum time between two records, closer ones pass unfiltered [s]
+constexpr double FILTER_MIN_DT = 0.05;
+/// Track filter: position deviation from the prediction after which the filter restarts [m]
+constexpr double FILTER_MAX_RESIDUAL = 2000.0;
+/// Track filter: distance from the local plane's origin after which the origin moves [m]
+constexpr double FILTER_REBASE_DIST = 50000.0;
+/// Track filter: measurement noise of a given ground speed [m/s]
+constexpr double FILTER_SPEED_NOISE = 1.0;
+/// Track filter: measurement noise of a given track [rad]
+constexpr double FILTER_TRACK_NOISE = 0.035;
+/// Track filter: measurement noise of a given track rate [rad/s]
+constexpr double FILTER_TURN_NOISE = 0.005;
+/// Track filter: measurement noise of a given vertical speed [m/s]
+constexpr double FILTER_VS_NOISE = 1.0;
+/// Track filter: process noise, random horizontal acceleration [m/s^2]
+constexpr double FILTER_ACCEL_NOISE = 2.0;
+/// Track filter: process noise, random change of turn rate [rad/s^2]
+constexpr double FILTER_TURN_ACCEL_NOISE = 0.02;
+/// Track filter: process noise, random vertical acceleration [m/s^2]
+constexpr double FILTER_VACCEL_NOISE = 1.0;
+
+/// Single-record spawn: minimum time between the dead-reckoned `from` and the received `to` position
+constexpr auto SPAWN_DR_MIN_DIFF = std::chrono::seconds(1);
+/// Smoothing factor for the average time from first data to display
+constexpr float TTFD_SMOOTHING = 0.1f;
+
+/// Terrain cache: distance between two elevation samples [m]
+constexpr double TERRAIN_CELL_M = 50.0;
+/// Terrain cache: number of cells per side of a tile
+constexpr int TERRAIN_TILE_CELLS = 16;
+/// Terrain cache: maximum number of tiles before the cache is flushed
+constexpr size_t TERRAIN_MAX_TILES = 2048;
+
+/// Model matching cache: maximum number of type/airline/livery combinations remembered
+constexpr size_t MDL_MATCH_CACHE_MAX = 500;
+
+/// Ownship: minimum change in latitude or longitude before the new position is published to the network thread [deg]
+constexpr double OWNSHIP_MIN_MOVE_DEG = 0.01;
+
+/// Plane maintenance: minimum number of aircraft with fresh data processed per call, even if over budget
+constexpr size_t MAINT_MIN_ENTRIES = 20;
+/// Plane maintenance: number of consecutive calls over budget before a warning is logged
+constexpr int MAINT_WARN_OVER_BUDGET = 100;
+
+/// Benchmark: number of synthetic aircraft
+constexpr size_t BENCH_NUM_AIRCRAFT = 10000;
+/// Benchmark: latitude of the synthetic traffic's center
+constexpr double BENCH_LAT = 45.0;
+/// Benchmark: longitude of the synthetic traffic's center
+constexpr double BENCH_LON = 7.0;
+/// Benchmark: number of updates per aircraft for the label
+constexpr int BENCH_LABEL_UPDATES = 50;
+/// Benchmark: number of updates per aircraft for the track filter
+constexpr int BENCH_FILTER_UPDATES = 60;
+/// Benchmark: number of updates after which the track filter is considered settled
+constexpr int BENCH_FILTER_SETTLE = 10;
+/// Benchmark: standard deviation of the track filter's position and altitude noise [m]
+constexpr double BENCH_FILTER_NOISE = 20.0;
+/// Benchmark: radius of the circles the track filter's aircraft fly [m]
+constexpr double BENCH_FILTER_RADIUS = 5000.0;
+/// Benchmark: speed of the track filter's aircraft [m/s]
+constexpr double BENCH_FILTER_SPEED = 100.0;
+/// Benchmark: altitude of the track filter's aircraft [m]
+constexpr double BENCH_FILTER_ALT = 3000.0;
+
+/// Level of detail: time detail updates in every n-th frame only
+constexpr int LOD_MEASURE_INTERVAL = 16;
+/// Level of detail: smoothing factor for the average cost of a detail update
+constexpr float LOD_COST_SMOOTHING = 0.1f;
+/// Level of detail: update interval in frames of lightweight objects, see `PlanesCategoryPolicy`
+constexpr int LOD_INTVL_LIGHT = 8;
+
+/// Sleeping planes: maximum difference in position between `from` and `to` to be considered stationary [m]
+constexpr float SLEEP_MAX_DIST_M = 0.05f;
+/// Sleeping planes: maximum difference in pitch, roll, heading between `from` and `to` to be considered stationary [deg]
+constexpr float SLEEP_MAX_ANGLE = 0.1f;
+
+/// Spatial index: cell size of the grid [m]
+constexpr float SPATIAL_CELL_M = 1852.0f;
+/// Spatial index: maximum number of nearest planes provided via dataRefs
+constexpr size_t SPATIAL_DR_MAX_N = 50;
+
+/// Tiers: minimum hysteresis margin of full planes before demoting
+constexpr size_t TIER_HYST_MIN = 10;
+/// Tiers: hysteresis margin is this fraction (1/n) of the configured number of full planes
+constexpr size_t TIER_HYST_DIV = 10;
+
+/// Timer wheel: duration of one tick [ms]
+constexpr uint64_t TIMER_TICK_MS = 250;
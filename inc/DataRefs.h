@@ -0,0 +1,64 @@
+/// @file       DataRefs.h
+/// @brief      dataRefs XPPlanes provides to other plugins, e.g. for statistics
+/// @details    All provided dataRefs are read-only and start with `XPPlanes/`.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Provided dataRefs
+//
+
+/// Defines one dataRef XPPlanes provides, read-only, value is fetched via a callback function
+class DataRefDefTy {
+public:
+    const char*     name    = nullptr;  ///< dataRef name
+    int   (*fInt)()         = nullptr;  ///< function returning an integer value
+    float (*fFloat)()       = nullptr;  ///< function returning a float value
+    int   (*fIntArr)(int*, int, int)     = nullptr; ///< function returning integer array values, semantics like `XPLMGetDatavi`
+    int   (*fFloatArr)(float*, int, int) = nullptr; ///< function returning float array values, semantics like `XPLMGetDatavf`
+    XPLMDataRef     hDR     = nullptr;  ///< handle of the registered dataRef
+
+public:
+    // Constructors
+    DataRefDefTy (const char* _name, int (*_f)()) : name(_name), fInt(_f) {}
+    DataRefDefTy (const char* _name, float (*_f)()) : name(_name), fFloat(_f) {}
+    DataRefDefTy (const char* _name, int (*_f)(int*, int, int)) : name(_name), fIntArr(_f) {}
+    DataRefDefTy (const char* _name, int (*_f)(float*, int, int)) : name(_name), fFloatArr(_f) {}
+    
+    /// The dataRef's type
+    XPLMDataTypeID GetType () const
+    {
+        return
+        fInt        ? xplmType_Int :
+        fFloat      ? xplmType_Float :
+        fIntArr     ? xplmType_IntArray :
+                      xplmType_FloatArray;
+    }
+};
+
+//
+// MARK: Global Functions
+//
+
+/// Register all provided dataRefs
+void DataRefsStartup ();
+
+/// Unregister all provided dataRefs
+void DataRefsShutdown ();
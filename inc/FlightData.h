@@ -39,15 +39,25 @@ public:
     std::string tailNum;            ///< tail number / registration, also used as special livery code (optional, for model matching)
     std::string callSign;           ///< call sign
     std::string label;              ///< label text
+    size_t      labelKey    = 0;    ///< hash of the label-defining fields, computed on ingest, see ComputeLabelKey()
+    uint8_t     category    = 0;    ///< emitter category code, see FlightDataCatCode(), `0` if unknown
     
     // Validity
     tsTy        ts;                 ///< timestamp
+    std::chrono::steady_clock::time_point tsRcvd;   ///< when the data was received, see PlaneTimeToDisplay()
     
     // Location
     double      lat         = NAN;  ///< latitude
     double      lon         = NAN;  ///< longitude
     double      alt_m       = NAN;  ///< altitude in meter above ground
     bool        bGnd        = false;///< on the ground?
+    bool        bGndAltPending = false; ///< ground altitude only provisional, waiting for terrain probes
+    
+    // Movement
+    float       track       = NAN;  ///< track over ground [deg true]
+    float       gs_m        = NAN;  ///< ground speed [m/s]
+    float       vs_m        = NAN;  ///< vertical speed [m/s], positive is up
+    float       trackRate   = NAN;  ///< rate of track change [deg/s], positive is right
     
     // Attitude
     float       pitch       = NAN;  ///< Pitch in degres to rotate the object, positive is up.
@@ -98,8 +108,18 @@ protected:
     ///          validations before doing so like
     ///          timestamp within grace period and sorted.
     static bool AddNew (std::shared_ptr<FlightData>&& pFD);
+    /// @brief Shall a record be dropped before parsing it fully, as it is ownship's, outside the region of interest, barred by its category's policy, or too close to the previous one?
+    /// @param id Aircraft id as peeked from the raw record
+    /// @param tsIn Raw timestamp as peeked from the raw record, see SetTimestamp()
+    /// @param lat Latitude as peeked from the raw record, `NAN` if unknown
+    /// @param lon Longitude as peeked from the raw record, `NAN` if unknown
+    /// @param cat Emitter category code as peeked from the raw record, `0` if unknown
+    static bool DropBeforeParse (XPMPPlaneID id, double tsIn, double lat, double lon, uint8_t cat);
     
 public:
+    /// Default constructor creates an empty object, e.g. for restoring a snapshot
+    FlightData () {}
+    
     /// Constructor: Creates a FlightData object from single record CSV-style data
     FlightData (const std::string& csv);
     
@@ -112,13 +132,19 @@ public:
     ///          - If larger than 1577836800.0  -> absolute Unix timestamp in seconds, supports decimals
     ///          - otherwise relative timestamp
     ///          NAN is handled as 0.0, ie. "now"
-    void SetTimestamp (double tsIn);
+    void SetTimestamp (double tsIn) { ts = ConvTimestamp(tsIn); }
+    /// Convert a timestamp input value, see SetTimestamp()
+    static tsTy ConvTimestamp (double tsIn);
 
     /// Order is solely by timestamp
     bool operator< (const FlightData& o) const { return ts < o.ts; }
     
     /// Has usable data? (Has at least position information)
     bool IsUsable () const;
+    /// Has track and ground speed, so that the position can be dead-reckoned?
+    bool CanDeadReckon () const { return !std::isnan(track) && !std::isnan(gs_m); }
+    /// Create a copy, moved along track and ground speed to another point in time
+    std::shared_ptr<FlightData> DeadReckon (const tsTy& tsAt) const;
     
     /// Convert to XP's drawInfo
     operator XPLMDrawInfo_t () const;
@@ -128,14 +154,28 @@ public:
     /// Replace any remaining `NAN`s with values from the other object
     void NANtoCopy (const FlightData& o);
     
+    /// @brief Compute `labelKey` from the fields that define the label
+    /// @details An explicit `label` alone defines the label, otherwise call sign and type do.
+    ///          Never returns `0`, which is reserved for "no label yet".
+    void ComputeLabelKey ();
+    /// Build the aircraft label: explicit `label`, or call sign (hex id if none) plus type
+    void BuildLabel (std::string& lbl) const;
+    
 protected:
    
     /// @brief RTTFC: Interprets the data as an RTTFC line
     /// @see https://www.flyrealtraffic.com/RTdev2.0.pdf
     bool FillFromRTTFC (const std::string& csv);
     
+    /// RTTFC: Finds just id, timestamp, location, and category in an RTTFC line, without converting anything else
+    static bool PeekRTTFC (const std::string& csv, XPMPPlaneID& id, double& tsIn,
+                           double& lat, double& lon, uint8_t& cat);
+    
     /// Converts the purpose-desgined XPPTraffic JSON format
     bool FillFromXPPTraffic (const JSON_Object* obj);
+    /// XPPTraffic: Finds just id, timestamp, location, and category in a JSON object, without converting anything else
+    static bool PeekXPPTraffic (const JSON_Object* obj, XPMPPlaneID& id, double& tsIn,
+                                double& lat, double& lon, uint8_t& cat);
     /// Helper to convert one plane object
 };
 
@@ -148,6 +188,23 @@ typedef std::list<ptrFlightDataTy> listFlightDataTy;
 /// Map indexed by plane id holding lists of flight data elements
 typedef std::map<XPMPPlaneID,listFlightDataTy> mapListFlightDataTy;
 
+/// @brief Adaptive jitter buffer of one aircraft, sizes the delay added to incoming timestamps
+/// @details Learns how long after a record's timestamp the next record arrives,
+///          which is the delay needed to always have a future position to interpolate to,
+///          and targets the configured underrun probability.
+struct JitterBufTy {
+    tsTy    tsLast;                 ///< youngest timestamp received so far (before adding the delay)
+    double  mean    = NAN;          ///< smoothed required delay [s]
+    double  dev     = 0.0;          ///< smoothed mean deviation of the required delay [s]
+    double  delay   = NAN;          ///< current delay [s]
+    
+    /// Learn from a record received at `rcvd` with timestamp `ts`, returns the delay to add [s]
+    double Update (const tsTy& rcvd, const tsTy& ts);
+};
+
+/// Map indexed by plane id holding the jitter buffers
+typedef std::unordered_map<XPMPPlaneID,JitterBufTy> mapJitterBufTy;
+
 //
 // MARK: Exception class
 //
@@ -169,3 +226,41 @@ bool FlightDataStartup ();
 
 /// Shutdown the FlightData module
 void FlightDataShutdown ();
+
+/// Average delay added by the jitter buffers [s]
+float FlightDataBufferDelayAvg ();
+/// Number of records, which arrived later than the jitter buffer expected
+int FlightDataBufferUnderruns ();
+/// Number of records dropped before parsing as they were too close to the previous one
+int FlightDataNumDecimated ();
+/// @brief Main thread only: Publish ownship's identity and position, so that the network thread drops ownship's data and data outside the region of interest
+/// @details Only takes the lock if identity changed or the position moved by more than `OWNSHIP_MIN_MOVE_DEG`
+/// @param id Ownship's id, `0` if not hiding by id
+/// @param tail Ownship's tail number, empty if not hiding by tail number
+/// @param lat Ownship's latitude, `NAN` if not needed
+/// @param lon Ownship's longitude, `NAN` if not needed
+void FlightDataSetOwnship (XPMPPlaneID id, const char* tail, double lat, double lon);
+/// Main thread only: Read ownship's identity and position from X-Plane and publish them, see FlightDataSetOwnship()
+void FlightDataReadOwnship ();
+/// Shall a record restored from a snapshot be kept? Drops ownship's, out-of-region, and category-barred records like live data, must hold `glob.mtxListFD`
+bool FlightDataAcceptRestored (FlightData& fd);
+/// Number of records dropped before parsing as they are outside the region of interest
+int FlightDataNumOutOfRegion ();
+/// Minimum time between two positions of the same aircraft, either configured or the render rate
+tsTy::duration FlightDataMinTsDiff ();
+
+/// Number of emitter category codes: `0` for unknown plus `A0`..`D7`
+constexpr int FD_NUM_CAT = 33;
+/// Convert an emitter category like `C2` to its code `1`..`32`, `0` if unknown
+inline uint8_t FlightDataCatCode (const char* s)
+{
+    if (!s || s[0] < 'A' || s[0] > 'D' || s[1] < '0' || s[1] > '7' || std::isalnum(s[2]))
+        return 0;
+    return uint8_t(1 + (s[0] - 'A') * 8 + (s[1] - '0'));
+}
+/// Shall aircraft of the category be displayed as lightweight objects, see `PlanesCategoryPolicy`?
+bool FlightDataCatLight (uint8_t cat);
+/// Number of records dropped before parsing as their category's policy said so
+int FlightDataNumCatDropped ();
+/// Forget an aircraft's timing, track, and category, must hold `glob.mtxListFD`
+void FlightDataForget (XPMPPlaneID id);
@@ -47,10 +47,42 @@ public:
     /// Replace textures in `.obj` files on load if needed?
     bool            bObjReplTextures = true;
     
-    /// Buffering period in seconds
+    /// Buffering period in seconds, initial delay of adaptive jitter buffers
     int             bufferPeriod = 5;
+    /// Size buffering delay per aircraft based on its update interval and jitter?
+    bool            bBufferAdaptive = false;
+    /// Adaptive jitter buffer: target probability of data arriving too late [%]
+    int             bufferUnderrunPct = 2;
+    /// Region of interest: radius around ownship [km], data of aircraft outside is dropped before parsing, `0` switches off
+    int             regionRadiusKm = 0;
+    /// Region of interest: bounding boxes `south,west,north,east` in degrees, separated by `;`, `none` switches off
+    std::string     regionBoxes = "none";
+    /// Minimum time between two positions of the same aircraft [ms], closer data is dropped before parsing, `0` means one position per rendered frame
+    int             minUpdateDiffMs = 100;
+    /// Policy per emitter category, like `C1,C2:cap=30,rate=2000,light;B1:drop`, `none` switches off
+    std::string     catPolicy = "none";
+    /// Move planes along a smooth cubic path between positions instead of straight lines?
+    bool            bSmoothPath = false;
+    /// Smooth incoming positions with a Kalman filter per aircraft?
+    bool            bFilter = false;
+    /// Track filter: expected noise of received positions [m]
+    int             filterPosNoise = 20;
+    /// Track filter: expected noise of received altitudes [m]
+    int             filterAltNoise = 15;
     /// Remove a plane after how many seconds without fresh data?
     int             gracePeriod = 30;
+    /// Maximum time per flight loop spent on processing flight data [us]
+    int             maintBudget = 1000;
+    /// Maximum number of planes created per flight loop
+    int             maxCreatePerCycle = 5;
+    /// Maximum number of full planes, only the nearest to the camera are rendered, `0` means unlimited
+    int             maxFullPlanes = 0;
+    /// Maximum number of removed planes kept for reuse, `0` switches recycling off
+    int             recyclePoolSize = 50;
+    /// How long are removed planes kept for reuse? [s]
+    int             recycleTime = 60;
+    /// Interval for saving the traffic snapshot for a warm restart [s], `0` switches snapshots off
+    int             snapshotInterval = 30;
     /// Hide ownship data? (bitfield, see HIDEOS_BY_ID and HIDEOS_BY_REG)
     int             iHideOwnship = HIDEOS_BY_ID | HIDEOS_BY_REG;
     /// Shall we draw aircraft labels?
@@ -59,6 +91,14 @@ public:
     int             maxLabelDist = 5556;
     /// Cut off labels at XP's reported visibility mit?
     bool            bLabelCutOffAtVisibility = true;
+    /// Level of detail: distance beyond which configuration, lights, and animation update every 2nd frame only [m], `0` switches off
+    int             lodDist2 = 0;
+    /// Level of detail: distance beyond which they update every 4th frame only [m], `0` switches off
+    int             lodDist4 = 0;
+    /// Level of detail: distance beyond which they update every 8th frame only [m], `0` switches off
+    int             lodDist8 = 0;
+    /// Maximum time per flight loop spent on terrain probes [us]
+    int             terrainProbeBudget = 500;
     
     /// Do we want to control X-Plane's AI/Multiplayer planes for TCAS?
     bool            bAITcasControl  = true;
@@ -79,15 +119,37 @@ public:
     int             remoteTTL       = 8;
     /// Buffer size, ie. max message length we send over multicast
     int             remoteBufSize   = 8192;
+    /// Producers to send feedback to, `host:port` separated by `;`, host can be a multicast group, `none` switches off
+    std::string     feedbackTargets = "none";
+    /// Interval for sending feedback to producers [s], `0` switches off
+    int             feedbackInterval = 5;
+    /// Limits of the distance bands for feedback to producers [km], separated by `;`, each band farther out asks for half the update rate
+    std::string     feedbackBands = "10;50";
 
     // MARK: Dynamic Data
     
+    /// Spatial index of all planes (declared before `mapPlanes` as planes unregister when destroyed)
+    SpatialGridTy   spatial;
+    /// Bulk kinematics engine computing all planes' interpolation (declared before `mapPlanes` as planes release their slots when destroyed)
+    KinEngine       kin;
     /// Global map of all created planes
     mapPlanesTy     mapPlanes;
     /// Global map of available (potentially future) flight data
     mapListFlightDataTy mapListFD;
-    /// Mutex protecting access to the above mapListFD
+    /// Ids of aircraft which received flight data since last processed by PlaneMaintenance()
+    std::unordered_set<XPMPPlaneID> setDirtyFD;
+    /// Jitter buffers per aircraft
+    mapJitterBufTy  mapJitter;
+    /// Track filters per aircraft
+    mapTrackFilterTy mapFilter;
+    /// Timestamp of the last accepted record per aircraft (before adding the delay)
+    std::unordered_map<XPMPPlaneID,tsTy> mapLastTs;
+    /// Mutex protecting access to the above mapListFD, setDirtyFD, mapJitter, mapFilter, and mapLastTs
     std::mutex      mtxListFD;
+    /// Deadlines after which aircraft expire, if no fresh data arrives (main thread only)
+    TimerWheelTy    expiry;
+    /// Duration of the last rendered frame [s], read by the network thread to decimate data to the render rate
+    std::atomic<float> framePeriod { 0.0f };
     
     /// This plugin's id
     XPLMPluginID    pluginId        = 0;
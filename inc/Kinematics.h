@@ -0,0 +1,127 @@
+/// @file       Kinematics.h
+/// @brief      Bulk computation of all planes' interpolated position, attitude, and configuration
+/// @details    Keeps the from/to state of all active planes in structure-of-arrays form
+///             and computes all planes' current values in one vectorized pass per frame.
+///             Plane::UpdatePosition() then only copies out its result.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Kinematics Engine
+//
+
+/// Channels, ie. values, which are interpolated per plane
+enum KinChTy : int {
+    KC_X = 0,                       ///< local x coordinate
+    KC_Y,                           ///< local y coordinate
+    KC_Z,                           ///< local z coordinate
+    KC_PITCH,                       ///< pitch
+    KC_ROLL,                        ///< roll
+    KC_HEADING,                     ///< heading
+    KC_GEAR,                        ///< gear ratio, clamped to [0..1]
+    KC_NWS,                         ///< nose wheel steering angle
+    KC_FLAPS,                       ///< flap ratio, clamped to [0..1]
+    KC_SPOILERS,                    ///< spoiler ratio, clamped to [0..1]
+    KC_REVERSERS,                   ///< reversers deploy ratio, clamped to [0..1]
+    KC_THRUST,                      ///< thrust ratio, clamped to [-1..1]
+    KC_RPM,                         ///< engine/prop rpm
+    KC_COUNT                        ///< always last, number of channels
+};
+
+/// First channel, which is computed with the capped `f` factor (see MAX_F)
+constexpr int KC_FIRST_CAPPED = KC_PITCH;
+/// Number of location channels, which can follow a cubic path
+constexpr int KC_NUM_LOC = KC_Z + 1;
+
+/// Structure-of-arrays holding the from/to state of all active planes
+class KinEngine
+{
+protected:
+    /// Number of allocated slots, always a multiple of the vector width
+    size_t cap = 0;
+    /// Free slots available for reuse
+    std::vector<int> freeSlots;
+    /// Time of last bulk computation [s since epoch]
+    double lastNow = 0.0;
+
+    // Input per slot
+    std::vector<double> tsFrom;     ///< `from` timestamp [s since epoch]
+    std::vector<double> invDur;     ///< 1 / (to.ts - from.ts) [1/s]
+    std::vector<float>  base[KC_COUNT];     ///< `from` values
+    std::vector<float>  delta[KC_COUNT];    ///< precomputed differences `to - from`
+    
+    // Cubic Hermite path per slot, as correction of the straight line:
+    // `s(1-s)((1-s)A - sB)` with `A`/`B` the tangents at `from`/`to` minus `delta`
+    std::vector<float>  cubA[KC_NUM_LOC];   ///< `from` tangent's deviation from the straight line
+    std::vector<float>  cubB[KC_NUM_LOC];   ///< `to` tangent's deviation from the straight line
+    
+    // Dead reckoning per slot, replaces the straight from/to line beyond the `to` position
+    std::vector<double>  tsTo;      ///< `to` timestamp [s since epoch]
+    std::vector<uint8_t> drOn;      ///< dead reckoning available, ie. `to` has track and ground speed?
+    std::vector<float>   drTrack;   ///< track at `to` [rad]
+    std::vector<float>   drGs;      ///< ground speed at `to` [m/s]
+    std::vector<float>   drVs;      ///< vertical speed at `to` [m/s]
+    std::vector<float>   drTurn;    ///< track rate at `to` [rad/s]
+
+    // Output per slot
+    std::vector<float>  f;          ///< interpolation factor (uncapped)
+    std::vector<float>  fCap;       ///< interpolation factor, capped at MAX_F
+    std::vector<float>  out[KC_COUNT];      ///< interpolated values
+
+public:
+    /// Allocate a slot for a new plane, returns slot index
+    int Add ();
+    /// Release a slot
+    void Remove (int slot);
+    /// Number of slots currently in use
+    size_t NumUsed () const { return cap - freeSlots.size(); }
+
+    /// @brief Stores the from/to state of a plane, precomputes deltas
+    /// @param velFrom Path tangent at `from` in local coordinates [m/s], `nullptr` for a straight line
+    /// @param velTo Path tangent at `to` in local coordinates [m/s], `nullptr` for a straight line
+    void Set (int slot,
+              const FlightData& from, const XPLMDrawInfo_t& diFrom,
+              const FlightData& to,   const XPLMDrawInfo_t& diTo,
+              const float* velFrom = nullptr, const float* velTo = nullptr);
+
+    /// @brief Computes all slots' interpolated values in one pass
+    /// @param now Current time [s since epoch]
+    void Compute (double now);
+
+    /// Uncapped interpolation factor of a slot as of last Compute()
+    float GetF (int slot) const { return f[size_t(slot)]; }
+    /// Interpolated value of a slot as of last Compute()
+    float Get (int slot, KinChTy ch) const { return out[ch][size_t(slot)]; }
+
+    /// Cleanup all slots
+    void Clear ();
+
+protected:
+    /// Grow all arrays to a new capacity
+    void Grow (size_t newCap);
+    /// Compute just one slot (scalar), used when a slot changes in between two bulk passes
+    void ComputeSlot (size_t i);
+    /// Overwrite a slot's location and heading by dead reckoning from its `to` position along track, speed, and track rate
+    void DeadReckon (size_t i, double now);
+};
+
+/// Convert a timestamp to seconds since epoch as used by the kinematics engine
+inline double KinTime (const tsTy& ts)
+{ return std::chrono::duration<double>(ts.time_since_epoch()).count(); }
@@ -31,3 +31,8 @@ bool ListenStartup ();
 
 /// Stop the network thread, wait for its shutdown, and cleanup the module
 void ListenShutdown ();
+
+/// @brief Regularly called from the flight loop: Sends feedback to registered producers if due
+/// @details The feedback tells producers what XPPlanes needs: ownship's position,
+///          the region of interest, update rates per distance band, and overload state.
+void ListenFeedback ();
@@ -44,24 +44,65 @@ protected:
     ptrFlightDataTy fdTo;           ///< the to-position for interpolation
     XPLMDrawInfo_t  diFrom;         ///< the from-position in XP speak
     XPLMDrawInfo_t  diTo;           ///< the to-position in XP speak
+    float           velFrom[3] = {0.0f, 0.0f, 0.0f};  ///< path tangent at `from` in local coordinates [m/s]
+    float           velTo[3]   = {0.0f, 0.0f, 0.0f};  ///< path tangent at `to` in local coordinates [m/s]
     /// _The_ factor: increases from 0 to 1 while `now` is between `from` and `to` (->interpolation),
     /// and becomes larger than 1 if `now` increases even beyond `to` (-> extrapolation)
     float           f = 0.5f;
 
     float       tTouchDown  = NAN;  ///< time since touch down    
+    float       elapsedSinceDetail = 0.0f;  ///< time since last detail update (configuration, lights, animation), see level of detail
+    int         kinIdx      = -1;   ///< slot in the kinematics engine `glob.kin`
+    bool        bStationary = false;///< `from` and `to` are identical in position, attitude, and configuration
+    bool        bSleeping   = false;///< stationary and fully updated: draw info is frozen until new data arrives
+    bool        bLight      = false;///< lightweight object as per category policy: straight paths, details updated at the lowest level of detail only
+    size_t      labelKey    = 0;    ///< FlightData::labelKey the current `label` was built from
+    
+    // Model-defining data as last requested, which can differ from the `ac...` members XPMP2 maintains
+    std::string mdlIcaoType;        ///< requested ICAO aircraft type
+    std::string mdlIcaoAirline;     ///< requested ICAO airline code
+    std::string mdlLivery;          ///< requested livery / tail number
+    bool        bMdlChangePending = false;  ///< model-defining data changed, ApplyModelChange() needs to run
 
     /// @brief Prepare given position for usage after taking over from passed-in smart pointer
     /// @param bFrom Store into `from` variables? Otherwise into `to`
     /// @param source From where to take over the data
     void TakeOverData (bool bFrom, ptrFlightDataTy&& source);
+    /// @brief Determine the path tangents at `from` and `to`
+    /// @param velPrev Tangent of the previous segment at the current `from` position, if any
+    /// @param pNext The record following `to`, if already available
+    void CalcPathVel (const float* velPrev, const FlightData* pNext);
+    /// Pass current from/to state on to the kinematics engine, wakes up a sleeping plane
+    void KinUpdate ();
+    /// Are `from` and `to` identical, so that there is nothing to animate?
+    bool IsStationary () const;
     
 public:
     /// Regularly called to update from/to positions from the list of available flight data
     void UpdateFromFlightData (listFlightDataTy& listFD,
                                const tsTy& now);
+    /// Perform a deferred model change, using previous matching results if available
+    void ApplyModelChange ();
+    /// @brief Was the current model requested for this type, airline, and livery?
+    /// @details The livery only counts if a CSL model exists for it, see MdlMatchLivery()
+    bool IsSameModel (const std::string& type, const std::string& airline, const std::string& livery) const;
+    /// Park the plane for later reuse: hide it and release per-plane resources
+    void Park ();
+    /// Reuse a parked plane for (potentially) another aircraft
+    void Recycle (ptrFlightDataTy&& from, ptrFlightDataTy&& to);
+    /// Has the plane reached its `to` position, so that it needs fresh data?
+    bool NeedsNewData (const tsTy& now) const { return fdTo->ts <= now; }
+    /// Timestamp of the `to` position, ie. the youngest data in use
+    const tsTy& GetToTs () const { return fdTo->ts; }
+    /// The from-position in use
+    const ptrFlightDataTy& GetFdFrom () const { return fdFrom; }
+    /// The to-position in use
+    const ptrFlightDataTy& GetFdTo () const { return fdTo; }
     
-    /// Determine ground altitude of a given location
+    /// Determine ground altitude of a given location, provisionally if terrain probes are pending
     void DetermineGndAlt (ptrFlightDataTy& fd);
+    /// Correct provisional ground altitudes once terrain probes are available, returns if any are still provisional
+    bool ResolveGndAlt ();
     
     /// @brief Determines if this plane shall be removed, sets `bToBeRemoved` if so
     /// @details Reasons for removal:
@@ -73,8 +114,30 @@ public:
 protected:
     static int flCounter;           ///< flight loop counter of last update
     static tsTy::rep ticksNow;      ///< 'now' timestamp in ticks since epoch
-    /// perform once-per-cycle activities
+public:
+    /// Level-of-detail statistics per frame
+    struct LodStatsTy {
+        int     nUpdated    = 0;        ///< number of detail updates performed
+        int     nSkipped    = 0;        ///< number of detail updates skipped
+        int     nSleeping   = 0;        ///< number of sleeping planes, which skipped all per-frame work
+        bool    bMeasured   = false;    ///< are detail updates timed in this frame?
+        float   measuredUs  = 0.0f;     ///< total time of all timed detail updates [us]
+    };
+    /// Level-of-detail statistics of the last completed frame
+    static const LodStatsTy& GetLodStats () { return lodLast; }
+    /// Average cost of one detail update [us]
+    static float GetLodCostUs () { return lodCostUs; }
+protected:
+    static LodStatsTy lodCurr;      ///< level-of-detail statistics of the current frame
+    static LodStatsTy lodLast;      ///< level-of-detail statistics of the last completed frame
+    static float lodCostUs;         ///< average cost of one detail update [us], smoothed
+    /// Update interval in frames for a given camera distance
+    static int LodInterval (float dist);
+    /// perform once-per-cycle activities, including the bulk computation of all planes' kinematics
     static void OncePerCycle (int _flCounter);
+public:
+    /// Recompute all planes' local coordinates after a change of the reference point
+    static void RebaseAll ();
 };
 
 /// Type of the map that stores and owns the plane objects
@@ -92,3 +155,36 @@ void PlaneShutdown();
 
 /// Regular updates from flight data
 void PlaneMaintenance ();
+
+/// Number of planes reused from the recycle pool
+int PlaneNumRecycled ();
+/// Number of planes currently parked in the recycle pool
+int PlaneNumParked ();
+/// Number of label rebuilds due to changed label-defining fields
+int PlaneLabelRebuilds ();
+/// Number of updates, which reused the existing label
+int PlaneLabelReused ();
+/// Average time from receiving an aircraft's first data to displaying it [s]
+float PlaneTimeToDisplay ();
+
+/// Number of detail updates performed in the last frame
+int PlaneLodUpdated ();
+/// Number of detail updates skipped in the last frame due to level of detail
+int PlaneLodSkipped ();
+/// Estimated time saved in the last frame due to level of detail [us]
+float PlaneLodSavedUs ();
+/// Number of stationary planes, which were asleep in the last frame
+int PlaneNumSleeping ();
+/// Did the last plane maintenance exceed its budget?
+bool PlaneMaintOverloaded ();
+
+/// The livery as far as it influences model matching, empty if no CSL model exists for it
+const std::string& MdlMatchLivery (const std::string& livery);
+
+/// Find a previous model matching result for type/airline/livery, returns empty string if not found
+std::string MdlMatchLookup (const std::string& type, const std::string& airline,
+                            const std::string& livery);
+
+/// Store a model matching result for type/airline/livery, evicting the least recently used one if full
+void MdlMatchStore (const std::string& type, const std::string& airline,
+                    const std::string& livery, const std::string& cslId);
@@ -0,0 +1,96 @@
+/// @file       Projection.h
+/// @brief      Thread-safe conversion between geodetic and X-Plane's local OpenGL coordinates
+/// @details    Reproduces X-Plane's local coordinate frame from the reference point dataRefs
+///             (`sim/flightmodel/position/lat_ref`/`lon_ref`), so that conversions
+///             don't require XPLM calls and can be done from any thread and in batches.
+///             The local frame is a Cartesian frame with its origin on sea level at the
+///             reference point, +X pointing east, +Y up, and +Z south.
+///             When the reference point changes (X-Plane shifting its origin)
+///             all cached local coordinates are rebased in one pass.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Projection parameters
+//
+
+/// @brief Parameters of the local frame, derived from the reference point
+/// @details The earth model is an ellipsoid given by semi-major axis and
+///          squared eccentricity, a sphere is the special case `e2 = 0`.
+struct ProjParamsTy {
+    double  lat_ref     = NAN;      ///< reference latitude [deg]
+    double  lon_ref     = NAN;      ///< reference longitude [deg]
+    double  a           = 0.0;      ///< semi-major axis [m]
+    double  e2          = 0.0;      ///< squared eccentricity
+    double  o[3]        = {0,0,0};  ///< ECEF position of the origin
+    double  east[3]     = {0,0,0};  ///< ECEF unit vector pointing east at the origin
+    double  north[3]    = {0,0,0};  ///< ECEF unit vector pointing north at the origin
+    double  up[3]       = {0,0,0};  ///< ECEF unit vector pointing up at the origin
+
+    /// Valid parameters defined?
+    bool IsValid () const { return a > 0.0 && !std::isnan(lat_ref) && !std::isnan(lon_ref); }
+
+    /// Set up for a reference point and an earth model
+    void Init (double _lat_ref, double _lon_ref, double _a, double _e2);
+
+    /// Geodetic to ECEF coordinates
+    void GeoToEcef (double lat, double lon, double alt_m, double ecef[3]) const;
+    /// ECEF to geodetic coordinates
+    void EcefToGeo (const double ecef[3], double& lat, double& lon, double& alt_m) const;
+
+    /// Convert world coordinates to local coordinates
+    void WorldToLocal (double lat, double lon, double alt_m,
+                       double& x, double& y, double& z) const;
+    /// Convert local coordinates to world coordinates
+    void LocalToWorld (double x, double y, double z,
+                       double& lat, double& lon, double& alt_m) const;
+    /// @brief Batch-convert world coordinates to local coordinates
+    /// @details Trigonometry is computed per point, the rotation into the local frame is vectorized
+    void WorldToLocal (size_t n,
+                       const double* lat, const double* lon, const double* alt_m,
+                       double* x, double* y, double* z) const;
+};
+
+//
+// MARK: Global Functions
+//
+
+/// @brief Main thread only: Reads the reference point, recalibrates if it changed
+/// @return `true` if the reference point changed, so that all cached local coordinates need a rebase
+bool ProjUpdateRef ();
+
+/// Thread-safe copy of the current projection parameters
+ProjParamsTy ProjGetParams ();
+
+/// @brief Convert world coordinates to local coordinates, can be called from any thread
+/// @note On the main thread falls back to `XPLMWorldToLocal` if the projection could not be calibrated
+void ProjWorldToLocal (double lat, double lon, double alt_m,
+                       double& x, double& y, double& z);
+
+/// @brief Convert local coordinates to world coordinates, can be called from any thread
+/// @note On the main thread falls back to `XPLMLocalToWorld` if the projection could not be calibrated
+void ProjLocalToWorld (double x, double y, double z,
+                       double& lat, double& lon, double& alt_m);
+
+/// @brief Batch-convert world coordinates to local coordinates, can be called from any thread
+/// @details Fetches projection parameters only once for the entire batch
+void ProjWorldToLocal (size_t n,
+                       const double* lat, const double* lon, const double* alt_m,
+                       double* x, double* y, double* z);
@@ -0,0 +1,39 @@
+/// @file       Snapshot.h
+/// @brief      Warm restart: Persists the latest traffic state and restores it upon enabling
+/// @details    The latest two positions per aircraft are written to a compact binary
+///             file when the plugin is disabled, and in regular intervals.
+///             Upon enabling, data not yet older than the grace period is restored
+///             straight into the flight data map, so that planes reappear immediately
+///             instead of waiting for two fresh records plus the buffering period.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Global Functions
+//
+
+/// Restore the traffic snapshot, if any, into the flight data map
+bool SnapshotStartup ();
+
+/// Save the current traffic state, called before flight data and planes are cleaned up
+void SnapshotShutdown ();
+
+/// Regularly called to save the current traffic state every `SnapshotInterval` seconds
+void SnapshotPeriodic ();
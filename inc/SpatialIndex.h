@@ -0,0 +1,114 @@
+/// @file       SpatialIndex.h
+/// @brief      Spatial index of all live planes for nearest-neighbour and radius queries
+/// @details    Uniform grid over the local x/z plane. Each plane is registered
+///             with its cell, updates only move a plane between cells when it
+///             crossed a cell border. Queries search outward from the query point's
+///             cell, so they don't need to scan all planes.
+///             The nearest planes around the camera and around the user's aircraft
+///             are also provided as array dataRefs.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Spatial Grid
+//
+
+/// Result of a query: a plane and its distance to the query point
+struct SpatialHitTy {
+    float       dist    = 0.0f;     ///< horizontal distance to query point [m]
+    XPMPPlaneID id      = 0;        ///< plane's id
+    
+    /// Order by distance
+    bool operator< (const SpatialHitTy& o) const { return dist < o.dist; }
+};
+
+/// List of query results
+typedef std::vector<SpatialHitTy> vecSpatialHitTy;
+
+/// Uniform grid of all planes in local coordinates
+class SpatialGridTy
+{
+protected:
+    /// One registered plane
+    struct EntryTy {
+        float       x = 0.0f;       ///< local x coordinate
+        float       z = 0.0f;       ///< local z coordinate
+        uint64_t    cell = 0;       ///< key of the cell the plane is registered with
+    };
+    /// All registered planes by id
+    std::unordered_map<XPMPPlaneID, EntryTy> entries;
+    /// Planes per cell
+    std::unordered_map<uint64_t, std::vector<XPMPPlaneID>> cells;
+    
+public:
+    /// Add a plane or update its position
+    void Update (XPMPPlaneID id, float x, float z);
+    /// Remove a plane
+    void Remove (XPMPPlaneID id);
+    /// Remove all planes
+    void Clear ();
+    /// Number of registered planes
+    size_t size () const { return entries.size(); }
+    /// Ids of all registered planes
+    void GetIds (std::vector<XPMPPlaneID>& out) const;
+    
+    /// @brief Up to `k` nearest planes to the given point, sorted by distance
+    /// @param x Local x coordinate of the query point
+    /// @param z Local z coordinate of the query point
+    /// @param k Maximum number of planes to return
+    /// @param[out] out Result list, sorted by distance
+    void Nearest (float x, float z, size_t k, vecSpatialHitTy& out) const;
+    
+    /// @brief All planes within the given radius around the point, sorted by distance
+    /// @param x Local x coordinate of the query point
+    /// @param z Local z coordinate of the query point
+    /// @param r Radius [m]
+    /// @param[out] out Result list, sorted by distance
+    void Radius (float x, float z, float r, vecSpatialHitTy& out) const;
+    
+protected:
+    /// Cell index of a coordinate
+    static long CellIdx (float v) { return long(std::floor(v / SPATIAL_CELL_M)); }
+    /// Cell key from cell indexes
+    static uint64_t CellKey (long ix, long iz)
+    { return (uint64_t(uint32_t(ix)) << 32) | uint64_t(uint32_t(iz)); }
+    /// Add all planes of the given cell to `out`, returns number of planes in the cell
+    size_t CollectCell (long ix, long iz, float x, float z, vecSpatialHitTy& out) const;
+    /// Add all planes to `out`, used if a grid search would visit more cells than there are planes
+    void CollectAll (float x, float z, vecSpatialHitTy& out) const;
+};
+
+//
+// MARK: Global Functions
+//
+
+/// Main thread only: Nearest planes to the camera, cached per frame, up to SPATIAL_DR_MAX_N
+const vecSpatialHitTy& SpatialNearestToCamera ();
+/// Main thread only: Nearest planes to the user's aircraft, cached per frame, up to SPATIAL_DR_MAX_N
+const vecSpatialHitTy& SpatialNearestToUser ();
+
+/// dataRef callback: ids of the nearest planes to the camera
+int SpatialDRCameraIds (int* outValues, int inOffset, int inMax);
+/// dataRef callback: distances of the nearest planes to the camera
+int SpatialDRCameraDist (float* outValues, int inOffset, int inMax);
+/// dataRef callback: ids of the nearest planes to the user's aircraft
+int SpatialDRUserIds (int* outValues, int inOffset, int inMax);
+/// dataRef callback: distances of the nearest planes to the user's aircraft
+int SpatialDRUserDist (float* outValues, int inOffset, int inMax);
@@ -0,0 +1,73 @@
+/// @file       Terrain.h
+/// @brief      Terrain elevation cache for aircraft on the ground
+/// @details    Ground altitude is sampled on a regular geographic grid, grouped into tiles.
+///             Lookups interpolate bilinearly between the four surrounding samples.
+///             Samples not yet in the cache are queued, and the queue is worked off
+///             nearest-to-camera first within a time budget per flight loop.
+///             The cache is invalidated when scenery is reloaded.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Global Functions
+//
+
+/// @brief Ground altitude [m MSL] at given position, answered from the cache only
+/// @details Missing samples are queued for probing by TerrainProcessQueue()
+/// @param lat Latitude
+/// @param lon Longitude
+/// @param[out] alt_m Ground altitude, only set if available
+/// @param bRetry Repeated lookup for the same position, not counted in the statistics
+/// @return `false` if samples are missing and the caller needs to try again later
+bool TerrainTryGetAlt (double lat, double lon, double& alt_m, bool bRetry = false);
+
+/// @brief Best guess of the ground altitude while TerrainTryGetAlt() waits for probes
+/// @details Takes the nearest known sample in the position's tile
+/// @param lat Latitude
+/// @param lon Longitude
+/// @param[out] alt_m Ground altitude, only set if a sample is known
+/// @return `false` if no sample is known nearby
+bool TerrainGuessAlt (double lat, double lon, double& alt_m);
+
+/// Main thread only: Ground altitude below the camera [m MSL], probed at most once per flight loop cycle, `NAN` if the probe missed
+float TerrainCameraGndAlt ();
+
+/// Main thread only: Process queued probes, nearest to camera first, within the configured time budget
+void TerrainProcessQueue ();
+
+/// Invalidate the cache, e.g. after scenery reload
+void TerrainCacheClear ();
+
+/// Number of lookups answered from the cache alone
+int TerrainCacheHits ();
+/// Number of lookups which had to wait for terrain probes
+int TerrainCacheMisses ();
+/// Share of lookups answered from the cache alone
+float TerrainCacheHitRate ();
+/// Number of terrain probes performed
+int TerrainProbeCount ();
+/// Number of samples waiting to be probed
+int TerrainQueueLength ();
+
+/// Initialize the Terrain module
+bool TerrainStartup ();
+
+/// Shutdown the Terrain module, frees all resources
+void TerrainShutdown ();
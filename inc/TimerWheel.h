@@ -0,0 +1,87 @@
+/// @file       TimerWheel.h
+/// @brief      Hierarchical timer wheel for expiry of aircraft without fresh data
+/// @details    Each aircraft has one deadline. Deadlines are sorted into slots of
+///             several wheel levels with increasing granularity, and are cascaded
+///             down to finer levels as time approaches. Advancing the wheel only
+///             touches the slots passed, so expiry costs O(expired).
+///             Extending a deadline is lazy: The entry stays in its slot and is
+///             only moved once its original time is reached.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Timer Wheel
+//
+
+/// Hierarchical timer wheel of deadlines per aircraft id
+class TimerWheelTy
+{
+public:
+    /// Time in ticks of TIMER_TICK_MS milliseconds
+    typedef uint64_t tickTy;
+    
+protected:
+    /// Number of bits per wheel level, ie. 64 slots per level
+    static constexpr int LVL_BITS = 6;
+    /// Number of slots per wheel level
+    static constexpr tickTy LVL_SLOTS = tickTy(1) << LVL_BITS;
+    /// Number of wheel levels
+    static constexpr int LEVELS = 4;
+    /// Maximum distance into the future that can be scheduled directly [ticks], longer ones are re-scheduled on the way
+    static constexpr tickTy MAX_DELTA = (tickTy(1) << (LVL_BITS * LEVELS)) - 1;
+    
+    /// Deadline per aircraft
+    struct EntryTy {
+        tickTy  deadline  = 0;      ///< when shall the aircraft expire?
+        tickTy  scheduled = 0;      ///< when is the entry due in the wheel? (can be before `deadline` after a lazy extension)
+    };
+    /// All scheduled aircraft
+    std::unordered_map<XPMPPlaneID, EntryTy> entries;
+    /// The wheels' slots, holding aircraft ids
+    std::vector<XPMPPlaneID> slots[LEVELS][LVL_SLOTS];
+    /// The next tick to be processed
+    tickTy curr = 0;
+    /// Has `curr` been initialized?
+    bool bInit = false;
+    
+public:
+    /// Convert a timestamp to ticks
+    static tickTy ToTick (const tsTy& ts)
+    { return tickTy(std::chrono::duration_cast<std::chrono::milliseconds>(ts.time_since_epoch()).count()) / TIMER_TICK_MS; }
+    
+    /// Set or move the deadline of an aircraft
+    void Schedule (XPMPPlaneID id, const tsTy& deadline);
+    /// Remove an aircraft from the wheel
+    void Cancel (XPMPPlaneID id) { entries.erase(id); }
+    /// @brief Advance the wheel up to `now`
+    /// @param now Current time
+    /// @param[out] expired Receives the ids of all aircraft whose deadline has passed, they are no longer scheduled
+    void Advance (const tsTy& now, std::vector<XPMPPlaneID>& expired);
+    /// Remove all aircraft
+    void Clear ();
+    /// Number of scheduled aircraft
+    size_t size () const { return entries.size(); }
+    
+protected:
+    /// Insert an entry into the slot corresponding to its deadline
+    void Insert (XPMPPlaneID id, EntryTy& e);
+    /// Move all entries of the current slot of level `lvl` down to finer levels
+    void Cascade (int lvl);
+};
@@ -0,0 +1,84 @@
+/// @file       TrackFilter.h
+/// @brief      Kalman filter smoothing noisy positions per aircraft in the ingest path
+/// @details    An extended Kalman filter with a constant turn rate and velocity (CTRV) model
+///             estimates position, ground speed, track, and track rate in a local
+///             east/north plane, a separate linear Kalman filter estimates
+///             altitude and vertical speed. Runs on the network thread as data arrives,
+///             replaces the received position by the filtered one, and annotates
+///             the data with the estimated velocities.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#pragma once
+
+//
+// MARK: Track Filter
+//
+
+/// Kalman filter state of one aircraft
+class TrackFilterTy
+{
+protected:
+    /// Horizontal state: east [m], north [m], ground speed [m/s], track [rad], track rate [rad/s]
+    enum { SX = 0, SY, SV, SPSI, SW, SN };
+    double  x[SN] = {0,0,0,0,0};    ///< horizontal state
+    double  P[SN][SN];              ///< horizontal state covariance
+    double  h = 0.0;                ///< altitude [m]
+    double  vh = 0.0;               ///< vertical speed [m/s]
+    double  Ph[2][2];               ///< altitude state covariance
+    bool    bAltValid = false;      ///< altitude state initialized?
+    bool    bVelValid = false;      ///< speed and track initialized?
+    double  lat0 = NAN;             ///< latitude of the local plane's origin
+    double  lon0 = NAN;             ///< longitude of the local plane's origin
+    tsTy    tsLast;                 ///< timestamp of the last processed record
+    
+public:
+    /// @brief Filter a record in place, must be called in timestamp order
+    /// @details Replaces position and altitude by the estimate and sets
+    ///          ground speed, track, track rate, and vertical speed.
+    ///          Out-of-order records pass unchanged.
+    void Process (FlightData& fd);
+    
+protected:
+    /// (Re)start the filter from a record
+    void Init (const FlightData& fd);
+    /// Initialize speed and track from the displacement between the first two records
+    void InitVel (double zx, double zy, double dt);
+    /// Predict the horizontal state `dt` seconds ahead
+    void Predict (double dt);
+    /// Update with a measurement of one state component
+    void Update (int i, double z, double r);
+    /// Start the altitude filter from a record
+    void InitAlt (const FlightData& fd);
+    /// Predict and update the altitude filter
+    void ProcessAlt (const FlightData& fd, double dt);
+    /// Move the origin of the local plane to the current position
+    void Rebase ();
+};
+
+/// Map indexed by plane id holding the track filters
+typedef std::unordered_map<XPMPPlaneID,TrackFilterTy> mapTrackFilterTy;
+
+//
+// MARK: Global Functions
+//
+
+/// Average cost of filtering one record [us]
+float TrackFilterCostUs ();
+/// Number of aircraft currently tracked by a filter
+int TrackFilterNumAircraft ();
@@ -58,9 +58,20 @@ std::istream& safeGetline(std::istream& is, std::string& t);
 inline double WeatherAltCorr_ft (double pressureAlt_ft, double hPa)
 { return pressureAlt_ft + ((hPa - HPA_STANDARD) * FT_per_HPA); }
 
+/// Pi
+constexpr double PI = 3.1415926535897932384626433832795028841971693993751;
+
+/// Convert degree to radians
+inline double deg2rad (double deg) { return deg * (PI / 180.0); }
+/// Convert radians to degree
+inline double rad2deg (double rad) { return rad * (180.0 / PI); }
+
 /// Return shortest turn from one heading to the other
 float HeadDiff (float from, float to);
 
+/// Move a position along a track by a distance, assuming a spherical earth and short distances
+void GeoMove (double& lat, double& lon, double track, double dist_m);
+
 /// @brief Rotation: Computes new rotation angle based on current + revolution in a (small) amount of time
 /// @param angle Last rotation angle as basis
 /// @param rpm Rotation speed in revolutions per minute
@@ -39,12 +39,18 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <list>
+#include <deque>
+#include <queue>
 #include <algorithm>
 #include <thread>
+#include <atomic>
 #include <mutex>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 
 // On Windows, 'max' and 'min' are defined macros in conflict with C++ library. Let's undefine them!
@@ -64,6 +70,8 @@
 #include "XPLMPlugin.h"
 #include "XPLMMenus.h"
 #include "XPLMGraphics.h"
+#include "XPLMScenery.h"
+#include "XPLMCamera.h"
 
 // XPMP2 - Public Header Files
 #include "XPMPMultiplayer.h"
@@ -74,6 +82,15 @@
 #include "Constants.h"
 #include "Utilities.h"
 #include "Listener.h"
+#include "Projection.h"
+#include "Terrain.h"
+#include "DataRefs.h"
 #include "FlightData.h"
+#include "TrackFilter.h"
+#include "TimerWheel.h"
+#include "Kinematics.h"
+#include "SpatialIndex.h"
 #include "Plane.h"
+#include "Snapshot.h"
+#include "Benchmark.h"
 #include "Global.h"
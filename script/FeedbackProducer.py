@@ -0,0 +1,179 @@
+#!/usr/bin/python3
+
+"""
+Demo traffic producer, which honours XPPlanes' feedback
+
+Generates aircraft flying circles around the user's plane and sends them
+in XPPTraffic format. XPPlanes' feedback (config `NetFeedbackTargets`)
+tells where the user's plane is, which region is of interest, and how often
+aircraft need updates depending on their distance. Aircraft outside the
+region are not sent at all, and farther away aircraft are sent less often.
+
+Works entirely on loopback, e.g. with the following XPPlanes config:
+    NetBcstPort 49800
+    NetFeedbackTargets 127.0.0.1:49901
+
+For usage info call
+    python3 FeedbackProducer.py -h
+
+
+MIT License
+
+Copyright (c) 2022 B.Hoppe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+"""
+
+import sys
+import math
+import json
+import time
+import socket
+import select
+import struct
+import argparse                     # handling command line arguments
+
+EARTH_RADIUS_M = 6371000.0
+
+""" === Feedback as last received, or defaults until then === """
+_feedback = {
+    "ownship": None,                # no idea where the user is, use --lat/--lon
+    "radius": 0,                    # no region of interest
+    "bands": [ { "dist" : None, "rate" : 1.0 } ],
+    "overload": False
+}
+
+""" === Receive feedback, if any is waiting === """
+def recvFeedback():
+    global _feedback
+    while select.select([fbSock], [], [], 0)[0]:
+        data, addr = fbSock.recvfrom(8192)
+        try:
+            _feedback = json.loads(data.decode('utf-8'))["feedback"]
+        except (ValueError, KeyError) as e:
+            print ("Ignoring invalid feedback from {}: {}".format(addr, e))
+            continue
+        if args.verbose:
+            print ("Feedback from {}: {}".format(addr, _feedback))
+
+""" === Center of the traffic: the user's plane === """
+def center():
+    os = _feedback.get("ownship")
+    if os and (os["lat"] or os["lon"]):
+        return os["lat"], os["lon"]
+    return args.lat, args.lon
+
+""" === Requested update rate for a distance [km], 0 if not of interest === """
+def rateForDist(dist_km: float) -> float:
+    radius = _feedback.get("radius", 0)
+    if radius > 0 and dist_km > radius:
+        return 0.0
+    for band in _feedback["bands"]:
+        if band["dist"] is None or dist_km <= band["dist"]:     # `null`: no limit
+            return band["rate"]
+    return _feedback["bands"][-1]["rate"]
+
+""" === One synthetic aircraft, flying a circle around the center === """
+class Aircraft:
+    def __init__(self, idx: int):
+        self.id = 0xF00000 + idx
+        self.radius_m = args.spacing * 1000.0 * (idx + 1)   # each one farther out
+        self.gs_kt = 120.0 + 10.0 * (idx % 10)
+        self.angle = idx * 0.7                              # spread around the circle [rad]
+        self.nextSend = 0.0
+
+    def position(self, now: float):
+        # angular speed along the circle, then position relative to the center
+        omega = self.gs_kt * 0.514444 / self.radius_m
+        a = self.angle + omega * now
+        lat0, lon0 = center()
+        dN = self.radius_m * math.cos(a)
+        dE = self.radius_m * math.sin(a)
+        lat = lat0 + math.degrees(dN / EARTH_RADIUS_M)
+        lon = lon0 + math.degrees(dE / (EARTH_RADIUS_M * math.cos(math.radians(lat0))))
+        track = (math.degrees(a) + 90.0) % 360.0            # flying clockwise
+        return lat, lon, track
+
+    def record(self, now: float) -> str:
+        lat, lon, track = self.position(now)
+        return json.dumps({
+            "id" : self.id,
+            "ident" : { "call" : "FB{:04d}".format(self.id & 0xFFFF) },
+            "type" : { "icao" : "C172" },
+            "position" : { "lat" : round(lat, 6), "lon" : round(lon, 6), "alt_geo" : args.alt,
+                           "gnd" : False, "track" : round(track, 1), "gs" : self.gs_kt,
+                           "timestamp" : now },
+            "attitude" : { "roll" : 0, "heading" : round(track, 1), "pitch" : 0 }
+        })
+
+""" === MAIN === """
+
+# --- Handling command line argumens ---
+parser = argparse.ArgumentParser(description='FeedbackProducer 0.1.0: Sends demo traffic, honouring XPPlanes\' feedback on region of interest and update rates')
+parser.add_argument('--host', metavar='NAME_OR_IP', help='UDP target host or ip to send the data to, defaults to \'localhost\'', default='localhost')
+parser.add_argument('--port', metavar='NUM', help='UDP port to send traffic data to, defaults to 49800', type=int, default=49800)
+parser.add_argument('--feedbackPort', metavar='NUM', help='UDP port to receive feedback on, defaults to 49901', type=int, default=49901)
+parser.add_argument('--feedbackGroup', metavar='MC_GROUP', help='Multicast group to receive feedback on, if XPPlanes sends feedback to a group')
+parser.add_argument('-n', '--num', metavar='NUM', help='Number of aircraft, defaults to 20', type=int, default=20)
+parser.add_argument('--spacing', metavar='KM', help='Distance between the aircraft\'s circles in km, defaults to 10', type=float, default=10.0)
+parser.add_argument('--lat', help='Latitude to use until feedback arrives', type=float, default=51.406292)
+parser.add_argument('--lon', help='Longitude to use until feedback arrives', type=float, default=6.939847)
+parser.add_argument('--alt', metavar='FT', help='Altitude of all aircraft in feet, defaults to 3000', type=int, default=3000)
+parser.add_argument('-v', '--verbose', help='Verbose output: Informs of feedback and statistics', action='store_true')
+
+args = parser.parse_args()
+
+# --- open the UDP sockets ---
+sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+fbSock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+fbSock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+fbSock.bind(('', args.feedbackPort))
+if args.feedbackGroup:
+    mreq = struct.pack("4sl", socket.inet_aton(args.feedbackGroup), socket.INADDR_ANY)
+    fbSock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+
+fleet = [Aircraft(i) for i in range(args.num)]
+nSent = 0
+nextStats = time.time() + 10.0
+
+try:
+    while True:
+        recvFeedback()
+        now = time.time()
+        for ac in fleet:
+            if now < ac.nextSend:
+                continue
+            rate = rateForDist(ac.radius_m / 1000.0)
+            if rate <= 0.0:                             # not of interest, check again later
+                ac.nextSend = now + 1.0
+                continue
+            sock.sendto(ac.record(now).encode('ascii'), (args.host, args.port))
+            nSent += 1
+            ac.nextSend = now + 1.0 / rate
+        if args.verbose and now >= nextStats:
+            print ("Sent {:.1f} records/s".format(nSent / 10.0))
+            nSent = 0
+            nextStats = now + 10.0
+        time.sleep(0.01)
+except KeyboardInterrupt:
+    pass
+
+# --- Cleanup ---
+sock.close()
+fbSock.close()
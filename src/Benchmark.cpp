@@ -0,0 +1,155 @@
+/// @file       Benchmark.cpp
+/// @brief      Benchmarks of performance-critical code paths with synthetic data
+/// @details    Only built if configured with `-D XPPLANES_BENCH=1`.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+#include <random>
+
+//
+// MARK: Track Filter
+//
+
+/// @brief Filter cost per update and accuracy with `BENCH_NUM_AIRCRAFT` synthetic tracks
+/// @details Aircraft fly circles at 100 m/s with one noisy record per second.
+///          The error is measured against the true position once the filters settled.
+static void BenchTrackFilter ()
+{
+    std::mt19937 rnd(1);
+    std::normal_distribution<double> noise(0.0, BENCH_FILTER_NOISE);
+    std::vector<TrackFilterTy> vecFilter(BENCH_NUM_AIRCRAFT);
+    const tsTy ts0 = std::chrono::system_clock::now();
+    const double cosLat = std::cos(deg2rad(BENCH_LAT));
+    double errRaw = 0.0, errFilter = 0.0, durUs = 0.0;
+    long n = 0;
+    
+    // The filters' cost statistics are guarded by the flight data lock
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    for (int k = 0; k < BENCH_FILTER_UPDATES; ++k) {
+        for (size_t i = 0; i < vecFilter.size(); ++i) {
+            // true position on the circle, each aircraft has its own circle and phase
+            const double a = BENCH_FILTER_SPEED / BENCH_FILTER_RADIUS * double(k) + double(i);
+            const double e = BENCH_FILTER_RADIUS * std::sin(a);
+            const double no = BENCH_FILTER_RADIUS * -std::cos(a) + double(i) * 10.0;
+            
+            // noisy record
+            FlightData fd;
+            fd._modeS_id = XPMPPlaneID(i + 1);
+            fd.ts = ts0 + std::chrono::duration_cast<tsTy::duration>(std::chrono::seconds(k));
+            const double eRaw = e + noise(rnd);
+            const double nRaw = no + noise(rnd);
+            fd.lat = BENCH_LAT + rad2deg(nRaw / EARTH_RADIUS_M);
+            fd.lon = BENCH_LON + rad2deg(eRaw / (EARTH_RADIUS_M * cosLat));
+            fd.alt_m = BENCH_FILTER_ALT + noise(rnd);
+            fd.bGnd = false;
+            
+            const auto tStart = std::chrono::steady_clock::now();
+            vecFilter[i].Process(fd);
+            durUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tStart).count();
+            
+            // error after the filters settled
+            if (k >= BENCH_FILTER_SETTLE) {
+                const double eFilter = deg2rad(fd.lon - BENCH_LON) * EARTH_RADIUS_M * cosLat;
+                const double nFilter = deg2rad(fd.lat - BENCH_LAT) * EARTH_RADIUS_M;
+                errRaw    += std::hypot(eRaw - e, nRaw - no);
+                errFilter += std::hypot(eFilter - e, nFilter - no);
+                ++n;
+            }
+        }
+    }
+    
+    LOG_MSG(logMSG, "Benchmark track filter: %lu aircraft x %d updates: %.3f us per update, mean position error %.1f m raw, %.1f m filtered",
+            (unsigned long)vecFilter.size(), BENCH_FILTER_UPDATES,
+            durUs / double(vecFilter.size() * BENCH_FILTER_UPDATES),
+            n ? errRaw / double(n) : 0.0, n ? errFilter / double(n) : 0.0);
+}
+
+//
+// MARK: Label
+//
+
+/// @brief Per-update cost of the aircraft label with and without the label cache
+/// @details `BENCH_NUM_AIRCRAFT` records with unchanging call sign (or none) and type.
+///          Without cache every update rebuilds the label.
+///          With cache the network thread computes the label key per record,
+///          and the main thread only compares keys.
+static void BenchLabel ()
+{
+    std::vector<FlightData> vecFD(BENCH_NUM_AIRCRAFT);
+    std::vector<std::string> vecLabel(vecFD.size());
+    std::vector<size_t> vecKey(vecFD.size(), 0);
+    for (size_t i = 0; i < vecFD.size(); ++i) {
+        vecFD[i]._modeS_id = XPMPPlaneID(i + 1);
+        if (i % 5)                                  // every 5th without call sign, labelled by hex id
+            vecFD[i].callSign = "DLH" + std::to_string(i);
+        vecFD[i].icaoType = "A320";
+    }
+    volatile size_t sink = 0;                       // keeps the optimizer from dropping the work
+    
+    // Without cache: rebuild the label with every update
+    auto tStart = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LABEL_UPDATES; ++k)
+        for (size_t i = 0; i < vecFD.size(); ++i) {
+            vecFD[i].BuildLabel(vecLabel[i]);
+            sink = sink + vecLabel[i].size();
+        }
+    const auto tRebuild = std::chrono::steady_clock::now() - tStart;
+    
+    // With cache, network thread: compute the label key of each record
+    tStart = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LABEL_UPDATES; ++k)
+        for (FlightData& fd: vecFD) {
+            fd.ComputeLabelKey();
+            sink = sink + fd.labelKey;
+        }
+    const auto tKey = std::chrono::steady_clock::now() - tStart;
+    
+    // With cache, main thread: rebuild only if the key changed
+    tStart = std::chrono::steady_clock::now();
+    for (int k = 0; k < BENCH_LABEL_UPDATES; ++k)
+        for (size_t i = 0; i < vecFD.size(); ++i) {
+            if (vecFD[i].labelKey != vecKey[i]) {
+                vecKey[i] = vecFD[i].labelKey;
+                vecFD[i].BuildLabel(vecLabel[i]);
+            }
+            sink = sink + vecKey[i];
+        }
+    const auto tCached = std::chrono::steady_clock::now() - tStart;
+    
+    const double n = double(vecFD.size() * BENCH_LABEL_UPDATES);
+    auto ns = [n](std::chrono::steady_clock::duration d)
+    { return std::chrono::duration<double, std::nano>(d).count() / n; };
+    LOG_MSG(logMSG, "Benchmark label: %lu aircraft x %d updates: without cache %.1f ns per update, with cache %.1f ns on the network thread plus %.1f ns on the main thread",
+            (unsigned long)vecFD.size(), BENCH_LABEL_UPDATES,
+            ns(tRebuild), ns(tKey), ns(tCached));
+}
+
+//
+// MARK: Global Functions
+//
+
+// Run all benchmarks and log the results
+void BenchmarkRun ()
+{
+    LOG_MSG(logMSG, "Benchmarks starting, data processing pauses meanwhile");
+    BenchTrackFilter();
+    BenchLabel();
+    LOG_MSG(logMSG, "Benchmarks done");
+}
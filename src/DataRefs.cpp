@@ -0,0 +1,122 @@
+/// @file       DataRefs.cpp
+/// @brief      dataRefs XPPlanes provides to other plugins, e.g. for statistics
+/// @details    All provided dataRefs are read-only and start with `XPPlanes/`.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: dataRef definitions
+//
+
+/// Definition of all provided dataRefs
+static DataRefDefTy DATAREFS[] = {
+    { XPPLANES "/terrain/cache_hits",       TerrainCacheHits        },
+    { XPPLANES "/terrain/cache_misses",     TerrainCacheMisses      },
+    { XPPLANES "/terrain/cache_hit_rate",   TerrainCacheHitRate     },
+    { XPPLANES "/terrain/probes",           TerrainProbeCount       },
+    { XPPLANES "/terrain/queue_length",     TerrainQueueLength      },
+    { XPPLANES "/planes/recycled",          PlaneNumRecycled        },
+    { XPPLANES "/planes/parked",            PlaneNumParked          },
+    { XPPLANES "/planes/sleeping",          PlaneNumSleeping        },
+    { XPPLANES "/planes/time_to_display",   PlaneTimeToDisplay      },
+    { XPPLANES "/planes/label_rebuilds",    PlaneLabelRebuilds      },
+    { XPPLANES "/planes/label_reused",      PlaneLabelReused        },
+    { XPPLANES "/buffer/delay_avg",         FlightDataBufferDelayAvg},
+    { XPPLANES "/buffer/underruns",         FlightDataBufferUnderruns},
+    { XPPLANES "/buffer/decimated",         FlightDataNumDecimated  },
+    { XPPLANES "/buffer/out_of_region",     FlightDataNumOutOfRegion},
+    { XPPLANES "/buffer/category_dropped",  FlightDataNumCatDropped },
+    { XPPLANES "/filter/cost_us",           TrackFilterCostUs       },
+    { XPPLANES "/filter/aircraft",          TrackFilterNumAircraft  },
+    { XPPLANES "/lod/detail_updates",       PlaneLodUpdated         },
+    { XPPLANES "/lod/detail_skipped",       PlaneLodSkipped         },
+    { XPPLANES "/lod/saved_us",             PlaneLodSavedUs         },
+    { XPPLANES "/nearest/camera/ids",       SpatialDRCameraIds      },
+    { XPPLANES "/nearest/camera/dist_m",    SpatialDRCameraDist     },
+    { XPPLANES "/nearest/user/ids",         SpatialDRUserIds        },
+    { XPPLANES "/nearest/user/dist_m",      SpatialDRUserDist       },
+};
+
+//
+// MARK: Callbacks
+//
+
+/// Callback for reading integer values
+static int DRGetInt (void* refcon)
+{
+    const DataRefDefTy* pDef = reinterpret_cast<const DataRefDefTy*>(refcon);
+    return pDef && pDef->fInt ? pDef->fInt() : 0;
+}
+
+/// Callback for reading float values
+static float DRGetFloat (void* refcon)
+{
+    const DataRefDefTy* pDef = reinterpret_cast<const DataRefDefTy*>(refcon);
+    return pDef && pDef->fFloat ? pDef->fFloat() : 0.0f;
+}
+
+/// Callback for reading integer array values
+static int DRGetIntArr (void* refcon, int* outValues, int inOffset, int inMax)
+{
+    const DataRefDefTy* pDef = reinterpret_cast<const DataRefDefTy*>(refcon);
+    return pDef && pDef->fIntArr ? pDef->fIntArr(outValues, inOffset, inMax) : 0;
+}
+
+/// Callback for reading float array values
+static int DRGetFloatArr (void* refcon, float* outValues, int inOffset, int inMax)
+{
+    const DataRefDefTy* pDef = reinterpret_cast<const DataRefDefTy*>(refcon);
+    return pDef && pDef->fFloatArr ? pDef->fFloatArr(outValues, inOffset, inMax) : 0;
+}
+
+//
+// MARK: Global Functions
+//
+
+// Register all provided dataRefs
+void DataRefsStartup ()
+{
+    for (DataRefDefTy& def: DATAREFS) {
+        if (def.hDR) continue;
+        def.hDR = XPLMRegisterDataAccessor(def.name,
+                                           def.GetType(),
+                                           0,                           // read-only
+                                           def.fInt   ? DRGetInt   : nullptr, nullptr,
+                                           def.fFloat ? DRGetFloat : nullptr, nullptr,
+                                           nullptr, nullptr,            // double
+                                           def.fIntArr   ? DRGetIntArr   : nullptr, nullptr,
+                                           def.fFloatArr ? DRGetFloatArr : nullptr, nullptr,
+                                           nullptr, nullptr,            // data
+                                           &def, nullptr);              // refcons
+        if (!def.hDR) {
+            LOG_MSG(logWARN, "Could not register dataRef %s", def.name);
+        }
+    }
+}
+
+// Unregister all provided dataRefs
+void DataRefsShutdown ()
+{
+    for (DataRefDefTy& def: DATAREFS) {
+        if (def.hDR)
+            XPLMUnregisterDataAccessor(def.hDR);
+        def.hDR = nullptr;
+    }
+}
@@ -76,6 +76,37 @@ static const char* CSV_DELIM = ",";
 #define TO_FLOAT(v) v = std::stof(tok); break;
 #define TO_STR(v) v = tok; break;
 
+// RTTFC: Finds just id, timestamp, location, and category in an RTTFC line
+bool FlightData::PeekRTTFC (const std::string& csv, XPMPPlaneID& id, double& tsIn,
+                           double& lat, double& lon, uint8_t& cat)
+{
+    if (csv.compare(0, 5, "RTTFC") != 0)
+        return false;
+    
+    // Walk the field delimiters only, the few fields needed are converted in place
+    int num = 0;
+    for (size_t pos = 0;
+         pos != std::string::npos && num <= RT_RTTFC_CATEGORY;
+         pos = csv.find(*CSV_DELIM, pos), ++num)
+    {
+        if (num) ++pos;                         // skip the delimiter itself
+        const char* tok = csv.c_str() + pos;
+        if (*tok == *CSV_DELIM || !*tok)        // empty field
+            continue;
+        if (num == RT_RTTFC_HEXID)
+            id = XPMPPlaneID(std::strtoul(tok, nullptr, 0));
+        else if (num == RT_RTTFC_LAT)
+            lat = std::strtod(tok, nullptr);
+        else if (num == RT_RTTFC_LON)
+            lon = std::strtod(tok, nullptr);
+        else if (num == RT_RTTFC_TIMESTAMP)
+            tsIn = std::strtod(tok, nullptr);
+        else if (num == RT_RTTFC_CATEGORY)
+            cat = FlightDataCatCode(tok);
+    }
+    return id != 0;
+}
+
 // RTTFC: Interprets the data as an RTTFC line
 bool FlightData::FillFromRTTFC (const std::string& csv)
 {
@@ -115,6 +146,17 @@ bool FlightData::FillFromRTTFC (const std::string& csv)
                 case RT_RTTFC_LAT:          TO_DOUBLE(lat);
                 case RT_RTTFC_LON:          TO_DOUBLE(lon);
                 case RT_RTTFC_ALT_BARO:     TO_DOUBLE(alt_baro_ft);
+                case RT_RTTFC_BARO_RATE:                // vertical rate is given in ft/min, convert to m/s
+                    vs_m = float(std::stod(tok) * MS_per_FPM);
+                    break;
+                case RT_RTTFC_GEOM_RATE:                // overwrites a baro rate, which is good
+                    vs_m = float(std::stod(tok) * MS_per_FPM);
+                    break;
+                case RT_RTTFC_TRACK_RATE:   TO_FLOAT(trackRate);
+                case RT_RTTFC_TRACK:        TO_FLOAT(track);
+                case RT_RTTFC_GSP:                      // ground speed is given in knots, convert to m/s
+                    gs_m = float(std::stod(tok) * MS_per_KT);
+                    break;
                 case RT_RTTFC_GND:
                     bGnd = std::stoi(tok) != 0;
                     if (bGnd) gear = 1.0f;              // on the ground need gear
@@ -129,6 +171,9 @@ bool FlightData::FillFromRTTFC (const std::string& csv)
                     break;
                 case RT_RTTFC_AC_TYPE:      TO_STR(icaoType);
                 case RT_RTTFC_AC_TAILNO:    TO_STR(tailNum);
+                case RT_RTTFC_CATEGORY:
+                    category = FlightDataCatCode(tok.c_str());
+                    break;
                 case RT_RTTFC_TIMESTAMP:
                     SetTimestamp(std::stod(tok));
                     break;
@@ -13,7 +13,8 @@
 ///                  "type" : {
 ///                    "icao" : "C172",
 ///                    "wingSpan" : 11.1,
-///                    "wingArea" : 16.2
+///                    "wingArea" : 16.2,
+///                    "category" : "A1"
 ///                  },
 ///                  "position" : {
 ///                    "lat" : 51.406292,
@@ -77,30 +78,50 @@
 
 #include "XPPlanes.h"
 
-/// Converts the purpose-desgined XPPTraffic JSON format
-bool FlightData::FillFromXPPTraffic (const JSON_Object* obj)
+/// Reads the `id` field, which can be a number or a hex string, returns `0` if there is none
+static XPMPPlaneID XPPTrafficId (const JSON_Object* obj, bool bLog)
 {
-    // `id` is mandatory, otherwise I wouldn't know for which plane
-    _modeS_id = 0;
     JSON_Value* objId = json_object_get_value(obj, "id");
     if (objId) {
         // We allow numerical values as well as hex strings
         switch (json_value_get_type(objId)) {
             case JSONNumber:
-                _modeS_id = XPMPPlaneID(jog_l(obj, "id"));
-                break;
+                return XPMPPlaneID(jog_l(obj, "id"));
                 
             case JSONString:
                 // convert from hex string
-                _modeS_id = XPMPPlaneID(std::strtoul(json_value_get_string(objId), nullptr, 16));
-                break;
+                return XPMPPlaneID(std::strtoul(json_value_get_string(objId), nullptr, 16));
                 
             default:
-                LOG_MSG(logDEBUG, "Field 'id' has neither number nor string type!");
+                if (bLog) LOG_MSG(logDEBUG, "Field 'id' has neither number nor string type!");
         }
     } else {
-        LOG_MSG(logDEBUG, "Field 'id' is missing!");
+        if (bLog) LOG_MSG(logDEBUG, "Field 'id' is missing!");
     }
+    return 0;
+}
+
+/// Finds just id, timestamp, location, and category in a JSON object
+bool FlightData::PeekXPPTraffic (const JSON_Object* obj, XPMPPlaneID& id, double& tsIn,
+                                 double& lat, double& lon, uint8_t& cat)
+{
+    id = XPPTrafficId(obj, false);
+    JSON_Object* pSub = json_object_get_object(obj, "position");
+    if (!id || !pSub)
+        return false;
+    tsIn = jog_n_nan(pSub, "timestamp");
+    lat  = jog_n_nan(pSub, "lat");
+    lon  = jog_n_nan(pSub, "lon");
+    if ((pSub = json_object_get_object(obj, "type")))
+        cat = FlightDataCatCode(json_object_get_string(pSub, "category"));
+    return true;
+}
+
+/// Converts the purpose-desgined XPPTraffic JSON format
+bool FlightData::FillFromXPPTraffic (const JSON_Object* obj)
+{
+    // `id` is mandatory, otherwise I wouldn't know for which plane
+    _modeS_id = XPPTrafficId(obj, true);
     
     // Also, the 'position' object is needed
     JSON_Object* pSub = json_object_get_object(obj, "position");
@@ -114,6 +135,10 @@ bool FlightData::FillFromXPPTraffic (const JSON_Object* obj)
     lon                 = jog_n_nan (pSub, "lon");
     alt_m               = jog_n_nan (pSub, "alt_geo") * XPMP2::M_per_FT;
     bGnd                = jog_b     (pSub, "gnd");
+    track               = float(jog_n_nan (pSub, "track"));
+    gs_m                = float(jog_n_nan (pSub, "gs") * MS_per_KT);
+    vs_m                = float(jog_n_nan (pSub, "vs") * MS_per_FPM);
+    trackRate           = float(jog_n_nan (pSub, "trackRate"));
     SetTimestamp(jog_n_nan(pSub, "timestamp"));
     
     // ident
@@ -129,6 +154,7 @@ bool FlightData::FillFromXPPTraffic (const JSON_Object* obj)
         icaoType        = jog_s     (pSub, "icao");
         wake.wingSpan_m = float(jog_n_nan (pSub, "wingSpan"));
         wake.wingArea_m2= float(jog_n_nan (pSub, "wingArea"));
+        category        = FlightDataCatCode(json_object_get_string(pSub, "category"));
     }
 
     // attitude
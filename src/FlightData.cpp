@@ -21,6 +21,236 @@
 
 #include "XPPlanes.h"
 
+//
+// MARK: Ownship
+//
+
+/// Ownship identity as published by the main thread, guarded by `glob.mtxListFD`
+struct OwnshipTy {
+    XPMPPlaneID id          = 0;    ///< ownship's id, `0` if not hiding by id
+    std::string tail;               ///< ownship's tail number, empty if not hiding by tail number
+    size_t      tailHash    = 0;    ///< hash of `tail`, so that records compare a number only
+    XPMPPlaneID idFromTail  = 0;    ///< id of the aircraft, which was seen with ownship's tail number
+    double      lat         = NAN;  ///< ownship's latitude, center of the region of interest
+    double      lon         = NAN;  ///< ownship's longitude, center of the region of interest
+    double      cosLat      = 1.0;  ///< cosine of `lat`, shrinking longitude differences to distances
+};
+static OwnshipTy gOwnship;
+/// Main thread only: What was published last, so that the lock is only taken if something changed
+static OwnshipTy gOwnshipPub;
+
+/// Forget all data of an aircraft, must hold `glob.mtxListFD`
+static void FlightDataPurge (XPMPPlaneID id)
+{
+    glob.mapListFD.erase(id);
+    FlightDataForget(id);
+}
+
+/// Is the record ownship's? Learns ownship's id from its tail number, must hold `glob.mtxListFD`
+static bool FlightDataIsOwnship (const FlightData& fd)
+{
+    if (fd._modeS_id == gOwnship.id || fd._modeS_id == gOwnship.idFromTail)
+        return fd._modeS_id != 0;
+    // Tail number is optional, so once found we remember the id to also match later data without tail
+    if (gOwnship.tailHash && !fd.tailNum.empty() &&
+        std::hash<std::string>()(fd.tailNum) == gOwnship.tailHash &&
+        fd.tailNum == gOwnship.tail)
+    {
+        LOG_MSG(logDEBUG, "Identified ownship by tail '%s' to be id 0x%06X",
+                gOwnship.tail.c_str(), fd._modeS_id);
+        gOwnship.idFromTail = fd._modeS_id;
+        FlightDataPurge(fd._modeS_id);
+        return true;
+    }
+    return false;
+}
+
+//
+// MARK: Region of Interest
+//
+
+/// A bounding box of the region of interest [deg]
+struct RegionBoxTy {
+    double  south = NAN;            ///< southern boundary
+    double  west  = NAN;            ///< western boundary
+    double  north = NAN;            ///< northern boundary
+    double  east  = NAN;            ///< eastern boundary, if less than `west` then the box spans the antimeridian
+    
+    /// Is the location inside the box?
+    bool Contains (double lat, double lon) const
+    {
+        return south <= lat && lat <= north &&
+               (west <= east ? (west <= lon && lon <= east) : (west <= lon || lon <= east));
+    }
+};
+/// All bounding boxes, set up during startup before the network thread starts
+static std::vector<RegionBoxTy> gRegionBoxes;
+
+/// Number of records dropped before parsing as they are outside the region of interest, guarded by `glob.mtxListFD`
+static int gNumOutOfRegion = 0;
+
+/// Parse the configured bounding boxes, format `south,west,north,east;...`
+static void FlightDataParseRegionBoxes ()
+{
+    gRegionBoxes.clear();
+    if (glob.regionBoxes.empty() || glob.regionBoxes == "none")
+        return;
+    StrTokens tBoxes(glob.regionBoxes, ";");
+    while (!tBoxes.finished()) {
+        const std::string sBox = tBoxes.next();
+        if (sBox.empty()) continue;
+        RegionBoxTy box;
+        if (std::sscanf(sBox.c_str(), "%lf,%lf,%lf,%lf", &box.south, &box.west, &box.north, &box.east) == 4 &&
+            box.south <= box.north)
+            gRegionBoxes.push_back(box);
+        else {
+            LOG_MSG(logWARN, "Ignoring invalid region box '%s', expected 'south,west,north,east'", sBox.c_str());
+        }
+    }
+}
+
+/// Is the location inside the region of interest? Must hold `glob.mtxListFD`
+static bool FlightDataInRegion (double lat, double lon)
+{
+    // Without a region, without a location, or without knowing where ownship is, everything is of interest
+    const bool bRadius = glob.regionRadiusKm > 0 && !std::isnan(gOwnship.lat);
+    if ((!bRadius && gRegionBoxes.empty()) || std::isnan(lat) || std::isnan(lon))
+        return true;
+    
+    // Within radius around ownship? Flat earth suffices for deciding interest
+    if (bRadius) {
+        const double dLon = std::remainder(lon - gOwnship.lon, 360.0);
+        const double dx = deg2rad(dLon) * gOwnship.cosLat;
+        const double dy = deg2rad(lat - gOwnship.lat);
+        const double r  = double(glob.regionRadiusKm) * 1000.0 / EARTH_RADIUS_M;
+        if (dx*dx + dy*dy <= r*r)
+            return true;
+    }
+    // Within any bounding box?
+    for (const RegionBoxTy& box: gRegionBoxes)
+        if (box.Contains(lat, lon))
+            return true;
+    return false;
+}
+
+//
+// MARK: Category Policy
+//
+
+/// What to do with aircraft of an emitter category
+struct CatPolicyTy {
+    bool    bDrop       = false;    ///< drop all data of the category
+    int     cap         = 0;        ///< maximum number of aircraft of the category, `0` for no limit
+    int     minDiffMs   = 0;        ///< minimum time between two positions of an aircraft [ms], `0` for the general `PlanesMinUpdateDiff`
+    bool    bLight      = false;    ///< display as lightweight object
+    
+    /// Any action defined at all?
+    bool IsDefined () const { return bDrop || cap > 0 || minDiffMs > 0 || bLight; }
+};
+/// Policies per category code, set up during startup before the network thread starts
+static CatPolicyTy gCatPolicy[FD_NUM_CAT];
+/// Is there any policy at all? Saves the lookup for the vast majority of setups without
+static bool gbCatPolicy = false;
+
+/// Category of aircraft with a policy, as not all records repeat the category, guarded by `glob.mtxListFD`
+static std::unordered_map<XPMPPlaneID,uint8_t> gCatOfId;
+/// Number of aircraft per category in `gCatOfId`, counted against the cap, guarded by `glob.mtxListFD`
+static int gCatCount[FD_NUM_CAT];
+/// Number of records dropped before parsing due to their category's policy, guarded by `glob.mtxListFD`
+static int gNumCatDropped = 0;
+
+/// @brief Parse the configured category policy
+/// @details Format `categories:actions;...` with categories like `C1,C2` or `C*`,
+///          and actions `drop`, `cap=N`, `rate=MS`, and `light`, e.g. `C1,C2:cap=30,rate=2000,light;B1:drop`
+static void FlightDataParseCatPolicy ()
+{
+    for (CatPolicyTy& pol: gCatPolicy)
+        pol = CatPolicyTy();
+    gbCatPolicy = false;
+    if (glob.catPolicy.empty() || glob.catPolicy == "none")
+        return;
+    StrTokens tEntries(glob.catPolicy, ";");
+    while (!tEntries.finished()) {
+        const std::string sEntry = tEntries.next();
+        if (sEntry.empty()) continue;
+        const std::pair<std::string,std::string> catsActs = str_split(sEntry, ":");
+        
+        // The actions first, they apply to all listed categories
+        CatPolicyTy pol;
+        bool bValid = !catsActs.second.empty();
+        StrTokens tActs(catsActs.second, ",");
+        while (bValid && !tActs.finished()) {
+            const std::string sAct = tActs.next();
+            if (sAct == "drop")                 pol.bDrop = true;
+            else if (sAct == "light")           pol.bLight = true;
+            else if (std::sscanf(sAct.c_str(), "cap=%d", &pol.cap) == 1 && pol.cap > 0) {}
+            else if (std::sscanf(sAct.c_str(), "rate=%d", &pol.minDiffMs) == 1 && pol.minDiffMs > 0) {}
+            else bValid = false;
+        }
+        
+        // Then the categories, `X*` stands for all of `X0`..`X7`
+        std::vector<uint8_t> cats;
+        StrTokens tCats(catsActs.first, ",");
+        while (bValid && !tCats.finished()) {
+            const std::string sCat = tCats.next();
+            if (sCat.size() == 2 && sCat[1] == '*' && 'A' <= sCat[0] && sCat[0] <= 'D') {
+                const uint8_t first = FlightDataCatCode((sCat.substr(0,1) + '0').c_str());
+                for (uint8_t c = first; c < first + 8; ++c)
+                    cats.push_back(c);
+            }
+            else if (const uint8_t c = FlightDataCatCode(sCat.c_str()))
+                cats.push_back(c);
+            else
+                bValid = false;
+        }
+        
+        if (!bValid || cats.empty()) {
+            LOG_MSG(logWARN, "Ignoring invalid category policy '%s', expected e.g. 'C1,C2:cap=30,rate=2000,light'", sEntry.c_str());
+            continue;
+        }
+        for (const uint8_t c: cats)
+            gCatPolicy[c] = pol;
+        gbCatPolicy = true;
+    }
+}
+
+/// Minimum time between two positions of an aircraft of the given category
+static tsTy::duration FlightDataCatMinTsDiff (uint8_t cat)
+{
+    const tsTy::duration minDiff = FlightDataMinTsDiff();
+    if (!gbCatPolicy || !gCatPolicy[cat].minDiffMs)
+        return minDiff;
+    return std::max<tsTy::duration>(minDiff, std::chrono::milliseconds(gCatPolicy[cat].minDiffMs));
+}
+
+/// Category of the aircraft: the given one, or the one remembered if not given, must hold `glob.mtxListFD`
+static uint8_t FlightDataCatRecall (XPMPPlaneID id, uint8_t cat)
+{
+    if (cat || !gbCatPolicy)
+        return cat;
+    auto iCat = gCatOfId.find(id);
+    return iCat == gCatOfId.end() ? 0 : iCat->second;
+}
+
+/// Does the category's policy bar the aircraft? Must hold `glob.mtxListFD`
+static bool FlightDataCatBarred (XPMPPlaneID id, uint8_t cat)
+{
+    const CatPolicyTy& pol = gCatPolicy[cat];
+    if (pol.bDrop)
+        return true;
+    // Cap reached, and the aircraft isn't one of those already counted?
+    return pol.cap > 0 && gCatCount[cat] >= pol.cap && !gCatOfId.count(id);
+}
+
+/// Remember an accepted aircraft's category and count it against the cap, must hold `glob.mtxListFD`
+static void FlightDataCatRemember (XPMPPlaneID id, uint8_t cat)
+{
+    if (!gbCatPolicy || !gCatPolicy[cat].IsDefined())
+        return;
+    if (gCatOfId.emplace(id, cat).second)
+        ++gCatCount[cat];
+}
+
 //
 // MARK: Object Creation
 //
@@ -64,6 +294,11 @@ bool FlightData::ProcessNetworkData (const std::string& s)
                         LOG_MSG(logWARN, "Couldn't find root object in parsed JSON array, index %lu:\n%.80s", (unsigned long)i, s.c_str());
                         bRet = false;
                     } else {
+                        XPMPPlaneID id = 0;
+                        double tsIn = NAN, lat = NAN, lon = NAN;
+                        uint8_t cat = 0;
+                        if (PeekXPPTraffic(pObj, id, tsIn, lat, lon, cat) && DropBeforeParse(id, tsIn, lat, lon, cat))
+                            continue;
                         if (!AddNew(std::make_shared<FlightData>(pObj)))
                             bRet = false;
                     }
@@ -79,12 +314,24 @@ bool FlightData::ProcessNetworkData (const std::string& s)
                     LOG_MSG(logWARN, "Couldn't find root object in parsed JSON data:\n%.80s", s.c_str());
                     return false;
                 }
+                XPMPPlaneID id = 0;
+                double tsIn = NAN, lat = NAN, lon = NAN;
+                uint8_t cat = 0;
+                if (PeekXPPTraffic(pObj, id, tsIn, lat, lon, cat) && DropBeforeParse(id, tsIn, lat, lon, cat))
+                    return true;
                 return AddNew(std::make_shared<FlightData>(pObj));
             }
                 
             // Single-record-style CSV data, calls constructor with std::string parameter
             case ',':
+            {
+                XPMPPlaneID id = 0;
+                double tsIn = NAN, lat = NAN, lon = NAN;
+                uint8_t cat = 0;
+                if (PeekRTTFC(s, id, tsIn, lat, lon, cat) && DropBeforeParse(id, tsIn, lat, lon, cat))
+                    return true;
                 return AddNew(std::make_shared<FlightData>(s));
+            }
         }
     }
     catch (const FlightData_error& e) {
@@ -106,11 +353,9 @@ bool FlightData::AddNew (std::shared_ptr<FlightData>&& pFD)
     // *** Timestamp ***
     
     // If no timestamp was given we assume 'now'
+    const tsTy now = std::chrono::system_clock::now();
     if (!pFD->ts.time_since_epoch().count())
-        pFD->ts = std::chrono::system_clock::now();
-    
-    // Add the buffering period to the timestamp
-    pFD->ts += std::chrono::seconds(glob.bufferPeriod);
+        pFD->ts = now;
     
     // One of the format accepted the input. Was it sufficiently detailed?
     if (!pFD->IsUsable()) {
@@ -119,35 +364,129 @@ bool FlightData::AddNew (std::shared_ptr<FlightData>&& pFD)
         return false;
     }
     
+    // Hash the label-defining fields already here, so the main thread only needs to compare keys
+    pFD->ComputeLabelKey();
+    pFD->tsRcvd = std::chrono::steady_clock::now();
+    
     // *** Add Data ***
+    
+    // insertion into the map/list of flight data is protected by a mutex
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    
+    // Ownship's data is not shown
+    if (FlightDataIsOwnship(*pFD)) {
+        pFD = nullptr;
+        return true;
+    }
+    
+    // Category policies also apply to records, which don't repeat the category
+    pFD->category = FlightDataCatRecall(pFD->_modeS_id, pFD->category);
+    // Barred by its category's policy? (DropBeforeParse is skipped if the quick peek fails)
+    if (gbCatPolicy && FlightDataCatBarred(pFD->_modeS_id, pFD->category)) {
+        ++gNumCatDropped;
+        pFD = nullptr;
+        return true;
+    }
+    
+    // Reject too old or too frequent data first, based on the raw timestamp plus the aircraft's
+    // current buffering delay, so that neither filter nor jitter buffer learn from rejected records
+    const tsTy tsRaw = pFD->ts;
+    double delay = double(glob.bufferPeriod);
+    if (glob.bBufferAdaptive) {
+        auto iJitter = glob.mapJitter.find(pFD->_modeS_id);
+        if (iJitter != glob.mapJitter.end() && !std::isnan(iJitter->second.delay))
+            delay = iJitter->second.delay;
+    }
+    auto AddDelay = [&tsRaw](double d)
+    { return tsRaw + std::chrono::duration_cast<tsTy::duration>(std::chrono::duration<double>(d)); };
+    pFD->ts = AddDelay(delay);
 
     // Discard data if already older than grace period
-    if (pFD->ts <= std::chrono::system_clock::now() - std::chrono::seconds(glob.gracePeriod)) {
+    if (pFD->ts <= now - std::chrono::seconds(glob.gracePeriod)) {
         LOG_MSG(logDEBUG, "Ignoring too old data for %06X from %.1fs ago", pFD->_modeS_id,
-                std::chrono::duration<double>(std::chrono::system_clock::now() - pFD->ts).count());
+                std::chrono::duration<double>(now - pFD->ts).count());
         pFD = nullptr;
         // But even then we return `true` as the data as such was OK...just was too late
         return true;
     }
     
-    // insertion into the map/list of flight data is protected by a mutex
-    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    // Find the position to insert, usually at the end, but slightly out-of-order data is sorted in
     listFlightDataTy& listFD = glob.mapListFD[pFD->_modeS_id];
-    if (listFD.empty() ||
-        listFD.back()->ts + MIN_TS_DIFF <= pFD->ts)  // only add if data is newer, this way it stays sorted
-        listFD.emplace_back(std::move(pFD));
-    else {
-        LOG_MSG(logDEBUG,
-                listFD.back()->ts == pFD->ts ?
-                "Ignoring same-timstamp data for %06X, ts = %ld" :
-                "Ignoring similar-timestamp or out-of-sequence data for %06X, ts = %ld", pFD->_modeS_id,
+    auto FindPos = [&listFD](const tsTy& ts)
+    {
+        auto iPos = listFD.end();
+        while (iPos != listFD.begin() && std::prev(iPos)->get()->ts > ts)
+            --iPos;
+        return iPos;
+    };
+    auto iPos = FindPos(pFD->ts);
+    // too close to its neighbours for meaningful interpolation?
+    const tsTy::duration minDiff = FlightDataCatMinTsDiff(pFD->category);
+    if ((iPos != listFD.begin() && std::prev(iPos)->get()->ts + minDiff > pFD->ts) ||
+        (iPos != listFD.end()   && pFD->ts + minDiff > iPos->get()->ts))
+    {
+        LOG_MSG(logDEBUG, "Ignoring similar-timestamp data for %06X, ts = %ld", pFD->_modeS_id,
                 (long)pFD->ts.time_since_epoch().count());
         pFD = nullptr;
     }
+    else {
+        // Smooth the position, using the data's own timestamp (not worth it for lightweight objects)
+        pFD->ts = tsRaw;
+        if (glob.bFilter && !FlightDataCatLight(pFD->category))
+            glob.mapFilter[pFD->_modeS_id].Process(*pFD);
+        
+        // Add the buffering delay to the timestamp, the adaptive buffer learns from the accepted record
+        if (glob.bBufferAdaptive) {
+            delay = glob.mapJitter[pFD->_modeS_id].Update(now, tsRaw);
+            iPos = FindPos(AddDelay(delay));    // the delay might have changed
+        }
+        pFD->ts = AddDelay(delay);
+        
+        tsTy& tsLast = glob.mapLastTs[pFD->_modeS_id];
+        if (tsRaw > tsLast)
+            tsLast = tsRaw;
+        FlightDataCatRemember(pFD->_modeS_id, pFD->category);
+        glob.setDirtyFD.insert(pFD->_modeS_id);     // tell PlaneMaintenance() there's something to do
+        listFD.emplace(iPos, std::move(pFD));
+    }
     
     return true;
 }
 
+/// Number of records dropped before parsing, guarded by `glob.mtxListFD`
+static int gNumDecimated = 0;
+
+// Shall a record be dropped before parsing it fully?
+bool FlightData::DropBeforeParse (XPMPPlaneID id, double tsIn, double lat, double lon, uint8_t cat)
+{
+    if (!id) return false;                      // let the full parsing find out what's wrong
+    const tsTy ts = ConvTimestamp(tsIn);
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    // Ownship's data is not shown
+    if (id == gOwnship.id || id == gOwnship.idFromTail)
+        return true;
+    // Outside the region of interest?
+    if (!FlightDataInRegion(lat, lon)) {
+        ++gNumOutOfRegion;
+        return true;
+    }
+    // Barred by its category's policy?
+    cat = FlightDataCatRecall(id, cat);
+    if (gbCatPolicy && FlightDataCatBarred(id, cat)) {
+        ++gNumCatDropped;
+        return true;
+    }
+    auto iLast = glob.mapLastTs.find(id);
+    if (iLast == glob.mapLastTs.end())
+        return false;
+    // Too close to the youngest accepted record? (Slightly older data is still welcome to be sorted in)
+    const tsTy::duration diff = ts > iLast->second ? ts - iLast->second : iLast->second - ts;
+    if (diff >= FlightDataCatMinTsDiff(cat))
+        return false;
+    ++gNumDecimated;
+    return true;
+}
+
 // Constructor: Creates a FlightData object from single record CSV-style data
 FlightData::FlightData (const std::string& csv)
 {
@@ -164,9 +503,10 @@ FlightData::FlightData (const JSON_Object* obj)
     }
 }
 
-// Set timestamp from input value
-void FlightData::SetTimestamp (double tsIn)
+// Convert a timestamp input value
+tsTy FlightData::ConvTimestamp (double tsIn)
 {
+    tsTy ts;
     // Consider NAN = 0.0 = "now"
     if (std::isnan(tsIn))
         tsIn = 0.0;
@@ -187,6 +527,7 @@ void FlightData::SetTimestamp (double tsIn)
         ts = std::chrono::system_clock::now();
         ts += std::chrono::milliseconds(long(tsIn*1000.0));
     }
+    return ts;
 }
 
 //
@@ -203,12 +544,24 @@ bool FlightData::IsUsable () const
     (!std::isnan(alt_m) || bGnd);           // and altitude information
 }
 
+// Create a copy, moved along track and ground speed to another point in time
+ptrFlightDataTy FlightData::DeadReckon (const tsTy& tsAt) const
+{
+    ptrFlightDataTy pFD = std::make_shared<FlightData>(*this);
+    const double dt = std::chrono::duration<double>(tsAt - ts).count();
+    GeoMove(pFD->lat, pFD->lon, track, gs_m * dt);
+    pFD->ts = tsAt;
+    if (std::isnan(pFD->heading))           // without heading we assume to head where we go
+        pFD->heading = track;
+    return pFD;
+}
+
 // Convert to XP's drawInfo
 FlightData::operator XPLMDrawInfo_t () const
 {
     double X, Y, Z;
-    XPLMWorldToLocal(lat, lon, NZ(alt_m),
-                     &X, &Y, &Z);
+    ProjWorldToLocal(lat, lon, NZ(alt_m),
+                     X, Y, Z);
     return XPLMDrawInfo_t { sizeof(XPLMDrawInfo_t),
                             float(X), float(Y), float(Z),
                             NZ(pitch), NZ(heading), NZ(roll) };
@@ -253,7 +606,108 @@ void FlightData::NANtoCopy (const FlightData& o)
     // we do specifically _not_ copy wake.lift, ie. if list is no longer given then we return to defaults
     
     // We do copy the label as it receives special treatment when processing the data
-    if (label.empty()) label = o.label;
+    if (label.empty() && !o.label.empty()) {
+        label = o.label;
+        labelKey = o.labelKey;              // explicit label alone defines the key
+    }
+}
+
+// Compute `labelKey` from the fields that define the label
+void FlightData::ComputeLabelKey ()
+{
+    const std::hash<std::string> h;
+    if (!label.empty())
+        labelKey = h(label);
+    else {
+        // combine call sign and type (like boost's hash_combine)
+        labelKey = h(callSign);
+        labelKey ^= h(icaoType) + 0x9e3779b9 + (labelKey << 6) + (labelKey >> 2);
+    }
+    if (!labelKey) labelKey = 1;
+}
+
+// Build the aircraft label
+void FlightData::BuildLabel (std::string& lbl) const
+{
+    if (!label.empty()) {                   // label is passed in
+        lbl = label;
+        return;
+    }
+    
+    if (callSign.empty()) {                 // Id is callsign or hex id
+        char sId[10];
+        snprintf(sId, sizeof(sId), "0x%06X", _modeS_id);
+        lbl = sId;
+    } else
+        lbl = callSign;
+    
+    if (!icaoType.empty()) {                // Add a/c type
+        lbl += " (";
+        lbl += icaoType;
+        lbl += ')';
+    }
+}
+
+//
+// MARK: Jitter Buffer
+//
+
+/// Number of records, which arrived later than the jitter buffer expected
+static int gJitterUnderruns = 0;
+
+/// Factor to the standard deviation of the required delay that meets the target underrun probability (normal distribution)
+static double JitterSigmaFactor ()
+{
+    static int pctCached = -1;
+    static double kCached = 0.0;
+    if (glob.bufferUnderrunPct != pctCached) {
+        // Find `k` with P(X > mean + k * sigma) = pct by bisection, only done when the config changes
+        pctCached = glob.bufferUnderrunPct;
+        const double p = std::clamp(pctCached, 1, 50) / 100.0;
+        double lo = 0.0, hi = 6.0;
+        for (int i = 0; i < 50; ++i) {
+            kCached = (lo + hi) / 2.0;
+            if (0.5 * std::erfc(kCached / std::sqrt(2.0)) > p)
+                lo = kCached;
+            else
+                hi = kCached;
+        }
+    }
+    return kCached;
+}
+
+// Learn from a record received at `rcvd` with timestamp `ts`, returns the delay to add [s]
+double JitterBufTy::Update (const tsTy& rcvd, const tsTy& ts)
+{
+    // First record: start with the configured buffering period
+    if (std::isnan(delay)) {
+        delay = double(glob.bufferPeriod);
+        tsLast = ts;
+        return delay;
+    }
+    
+    // The delay it would have needed so the previous youngest record
+    // had not been passed before this one arrived
+    const double need = std::chrono::duration<double>(rcvd - tsLast).count();
+    if (need > delay)
+        ++gJitterUnderruns;
+    if (std::isnan(mean)) {
+        mean = need;
+        dev  = need / 2.0;
+    } else {
+        dev  += JITTER_BETA  * (std::abs(need - mean) - dev);
+        mean += JITTER_ALPHA * (need - mean);
+    }
+    
+    // Target delay for the configured underrun probability
+    const double target = std::clamp(mean + JitterSigmaFactor() * JITTER_SIGMA_PER_DEV * dev,
+                                     0.0, double(glob.gracePeriod) / 2.0);
+    // Growing is immediate, shrinking is slow enough to keep the display times in order
+    const double dtData = std::max(0.0, std::chrono::duration<double>(ts - tsLast).count());
+    delay = target >= delay ? target : std::max(target, delay - JITTER_MAX_SHRINK * dtData);
+    if (ts > tsLast)
+        tsLast = ts;
+    return delay;
 }
 
 //
@@ -263,7 +717,8 @@ void FlightData::NANtoCopy (const FlightData& o)
 // Initialize the FlightData module
 bool FlightDataStartup ()
 {
-    // doesn't do anything at the moment
+    FlightDataParseRegionBoxes();
+    FlightDataParseCatPolicy();
     return true;
 }
 
@@ -272,4 +727,157 @@ void FlightDataShutdown ()
 {
     // cleanup all data in the map
     glob.mapListFD.clear();
+    glob.setDirtyFD.clear();
+    glob.mapJitter.clear();
+    glob.mapFilter.clear();
+    glob.mapLastTs.clear();
+    glob.expiry.Clear();
+    gOwnship = OwnshipTy();
+    gOwnshipPub = OwnshipTy();
+    gCatOfId.clear();
+    std::fill(std::begin(gCatCount), std::end(gCatCount), 0);
+}
+
+// Average delay added by the jitter buffers [s]
+float FlightDataBufferDelayAvg ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    if (glob.mapJitter.empty())
+        return 0.0f;
+    double sum = 0.0;
+    for (const auto& p: glob.mapJitter)
+        sum += p.second.delay;
+    return float(sum / double(glob.mapJitter.size()));
+}
+
+// Number of records, which arrived later than the jitter buffer expected
+int FlightDataBufferUnderruns ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return gJitterUnderruns;
+}
+
+// Number of records dropped before parsing as they were too close to the previous one
+int FlightDataNumDecimated ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return gNumDecimated;
+}
+
+// Main thread only: Publish ownship's identity and position
+void FlightDataSetOwnship (XPMPPlaneID id, const char* tail, double lat, double lon)
+{
+    // Publish only if identity changed or the position moved noticeably
+    const bool bPosChanged =
+        std::isnan(lat) != std::isnan(gOwnshipPub.lat) ||
+        (!std::isnan(lat) &&
+         (std::abs(lat - gOwnshipPub.lat) > OWNSHIP_MIN_MOVE_DEG ||
+          std::abs(std::remainder(lon - gOwnshipPub.lon, 360.0)) > OWNSHIP_MIN_MOVE_DEG));
+    if (!bPosChanged && id == gOwnshipPub.id && gOwnshipPub.tail == tail)
+        return;
+    gOwnshipPub.id   = id;
+    gOwnshipPub.tail = tail;
+    gOwnshipPub.lat  = lat;
+    gOwnshipPub.lon  = lon;
+    
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    gOwnship.lat = lat;
+    gOwnship.lon = lon;
+    gOwnship.cosLat = std::isnan(lat) ? 1.0 : std::cos(deg2rad(lat));
+    if (id != gOwnship.id) {
+        gOwnship.id = id;
+        if (id) FlightDataPurge(id);            // data received before is ownship's, too
+    }
+    if (gOwnship.tail != tail) {
+        gOwnship.tail = tail;
+        gOwnship.tailHash = gOwnship.tail.empty() ? 0 : std::hash<std::string>()(gOwnship.tail);
+        gOwnship.idFromTail = 0;                // will be learned again from incoming data
+    }
+}
+
+// Read ownship's identity and position from X-Plane and publish them
+void FlightDataReadOwnship ()
+{
+    static XPLMDataRef drModeSId = XPLMFindDataRef("sim/aircraft/view/acf_modeS_id");
+    static XPLMDataRef drTailNum = XPLMFindDataRef("sim/aircraft/view/acf_tailnum");
+    XPMPPlaneID osId = 0;
+    char osTail[41] = "";
+    if (drModeSId && glob.ShallHideOsById())                        // compare by ADS-B hex id?
+        osId = (XPMPPlaneID)XPLMGetDatai(drModeSId);                // read ownship's hex id
+    if (drTailNum && glob.ShallHideOsByReg()) {                     // compare by tail number / regsitration?
+        XPLMGetDatab(drTailNum, osTail, 0, sizeof(osTail)-1);       // read ownship tail number
+        osTail[sizeof(osTail)-1] = 0;                               // ensure zero-termination
+    }
+    // Ownship's position is the center of the region of interest
+    static XPLMDataRef drLat = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef drLon = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    double osLat = NAN, osLon = NAN;
+    if (glob.regionRadiusKm > 0 && drLat && drLon) {
+        osLat = XPLMGetDatad(drLat);
+        osLon = XPLMGetDatad(drLon);
+    }
+    FlightDataSetOwnship(osId, osTail, osLat, osLon);
+}
+
+// Shall a record restored from a snapshot be kept? Applies the same filters as to live data
+bool FlightDataAcceptRestored (FlightData& fd)
+{
+    // Ownship's data is not shown
+    if (FlightDataIsOwnship(fd))
+        return false;
+    // Outside the region of interest?
+    if (!FlightDataInRegion(fd.lat, fd.lon)) {
+        ++gNumOutOfRegion;
+        return false;
+    }
+    // Barred by its category's policy?
+    fd.category = FlightDataCatRecall(fd._modeS_id, fd.category);
+    if (gbCatPolicy && FlightDataCatBarred(fd._modeS_id, fd.category)) {
+        ++gNumCatDropped;
+        return false;
+    }
+    FlightDataCatRemember(fd._modeS_id, fd.category);
+    return true;
+}
+
+// Number of records dropped before parsing as they are outside the region of interest
+int FlightDataNumOutOfRegion ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return gNumOutOfRegion;
+}
+
+// Shall aircraft of the category be displayed as lightweight objects?
+bool FlightDataCatLight (uint8_t cat)
+{
+    return gbCatPolicy && gCatPolicy[cat].bLight;
+}
+
+// Number of records dropped before parsing as their category's policy said so
+int FlightDataNumCatDropped ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return gNumCatDropped;
+}
+
+// Forget an aircraft's timing, track, and category
+void FlightDataForget (XPMPPlaneID id)
+{
+    glob.mapJitter.erase(id);
+    glob.mapFilter.erase(id);
+    glob.mapLastTs.erase(id);
+    auto iCat = gCatOfId.find(id);
+    if (iCat != gCatOfId.end()) {
+        --gCatCount[iCat->second];
+        gCatOfId.erase(iCat);
+    }
+}
+
+// Minimum time between two positions of the same aircraft
+tsTy::duration FlightDataMinTsDiff ()
+{
+    const tsTy::duration minDiff = glob.minUpdateDiffMs > 0 ?
+        tsTy::duration(std::chrono::milliseconds(glob.minUpdateDiffMs)) :
+        std::chrono::duration_cast<tsTy::duration>(std::chrono::duration<float>(glob.framePeriod.load()));
+    return std::max<tsTy::duration>(minDiff, MIN_TS_DIFF);
 }
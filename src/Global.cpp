@@ -82,12 +82,32 @@ static CfgInfoTy CFGINFO[] = {
     { "ObjReplTextures",        glob.bObjReplTextures           },
     { "TCAS_Control",           glob.bAITcasControl             },
     { "PlanesBufferPeriod",     glob.bufferPeriod               },
+    { "PlanesBufferAdaptive",   glob.bBufferAdaptive            },
+    { "PlanesBufferUnderrun",   glob.bufferUnderrunPct          },
+    { "PlanesRegionRadius",     glob.regionRadiusKm             },
+    { "PlanesRegionBoxes",      glob.regionBoxes                },
+    { "PlanesMinUpdateDiff",    glob.minUpdateDiffMs            },
+    { "PlanesCategoryPolicy",   glob.catPolicy                  },
+    { "PlanesSmoothPath",       glob.bSmoothPath                },
+    { "FilterEnable",           glob.bFilter                    },
+    { "FilterPosNoise",         glob.filterPosNoise             },
+    { "FilterAltNoise",         glob.filterAltNoise             },
     { "PlanesGracePeriod",      glob.gracePeriod                },
+    { "PlanesMaintBudget",      glob.maintBudget                },
+    { "PlanesMaxCreate",        glob.maxCreatePerCycle          },
+    { "PlanesMaxFull",          glob.maxFullPlanes              },
+    { "PlanesRecyclePool",      glob.recyclePoolSize            },
+    { "PlanesRecycleTime",      glob.recycleTime                },
+    { "PlanesSnapshotInterval", glob.snapshotInterval           },
     { "PlanesClampAll",         glob.bClampAll                  },
     { "PlanesHideOwnship",      glob.iHideOwnship               },
     { "LabelsDraw",             glob.bDrawLabels                },
     { "LabelsMaxDist",          glob.maxLabelDist               },
     { "LabelsCutMaxVisible",    glob.bLabelCutOffAtVisibility   },
+    { "LODDist2",               glob.lodDist2                   },
+    { "LODDist4",               glob.lodDist4                   },
+    { "LODDist8",               glob.lodDist8                   },
+    { "TerrainProbeBudget",     glob.terrainProbeBudget         },
     { "MapEnable",              glob.bMapEnabled                },
     { "MapLabels",              glob.bMapLabels                 },
     { "NetMCGroup",             glob.listenMCGroup              },
@@ -95,6 +115,9 @@ static CfgInfoTy CFGINFO[] = {
     { "NetBcstPort",            glob.listenBcstPort             },
     { "NetTTL",                 glob.remoteTTL                  },
     { "NetBufSize",             glob.remoteBufSize              },
+    { "NetFeedbackTargets",     glob.feedbackTargets            },
+    { "NetFeedbackInterval",    glob.feedbackInterval           },
+    { "NetFeedbackBands",       glob.feedbackBands              },
 };
 
 //
@@ -0,0 +1,329 @@
+/// @file       Kinematics.cpp
+/// @brief      Bulk computation of all planes' interpolated position, attitude, and configuration
+/// @details    Keeps the from/to state of all active planes in structure-of-arrays form
+///             and computes all planes' current values in one vectorized pass per frame.
+///             Plane::UpdatePosition() then only copies out its result.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+#include <cfloat>
+
+//
+// MARK: SIMD abstraction
+//
+
+// A minimal set of vector operations, mapped to what the target platform offers.
+// On Mac universal builds each architecture is compiled separately, so the
+// right branch is taken per architecture. SSE2 is the x86-64 baseline,
+// wider instruction sets aren't used as the plugin must run on any CPU X-Plane runs on.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+typedef __m128 vfTy;                                    ///< vector of floats
+constexpr size_t KIN_W = 4;                             ///< vector width
+#define V_LOAD(p)       _mm_loadu_ps(p)
+#define V_STORE(p,v)    _mm_storeu_ps(p,v)
+#define V_SET1(x)       _mm_set1_ps(x)
+#define V_ADD(a,b)      _mm_add_ps(a,b)
+#define V_SUB(a,b)      _mm_sub_ps(a,b)
+#define V_MUL(a,b)      _mm_mul_ps(a,b)
+#define V_MIN(a,b)      _mm_min_ps(a,b)
+#define V_MAX(a,b)      _mm_max_ps(a,b)
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+typedef float32x4_t vfTy;                               ///< vector of floats
+constexpr size_t KIN_W = 4;                             ///< vector width
+#define V_LOAD(p)       vld1q_f32(p)
+#define V_STORE(p,v)    vst1q_f32(p,v)
+#define V_SET1(x)       vdupq_n_f32(x)
+#define V_ADD(a,b)      vaddq_f32(a,b)
+#define V_SUB(a,b)      vsubq_f32(a,b)
+#define V_MUL(a,b)      vmulq_f32(a,b)
+#define V_MIN(a,b)      vminq_f32(a,b)
+#define V_MAX(a,b)      vmaxq_f32(a,b)
+#else
+typedef float vfTy;                                     ///< no SIMD available, plain scalar
+constexpr size_t KIN_W = 1;                             ///< vector width
+#define V_LOAD(p)       (*(p))
+#define V_STORE(p,v)    (*(p) = (v))
+#define V_SET1(x)       (x)
+#define V_ADD(a,b)      ((a)+(b))
+#define V_SUB(a,b)      ((a)-(b))
+#define V_MUL(a,b)      ((a)*(b))
+#define V_MIN(a,b)      std::min<float>(a,b)
+#define V_MAX(a,b)      std::max<float>(a,b)
+#endif
+
+/// Multiply-add: f*d + b
+#define V_FMA(f,d,b)    V_ADD(V_MUL(f,d),b)
+
+/// Minimum number of slots allocated
+constexpr size_t KIN_MIN_CAP = 64;
+
+/// Lower limits per channel
+static const float KC_LO[KC_COUNT] = {
+    -FLT_MAX, -FLT_MAX, -FLT_MAX,           // x, y, z
+    -FLT_MAX, -FLT_MAX, -FLT_MAX,           // pitch, roll, heading
+    0.0f, -FLT_MAX, 0.0f, 0.0f, 0.0f,       // gear, nws, flaps, spoilers, reversers
+    -1.0f, -FLT_MAX                         // thrust, rpm
+};
+
+/// Upper limits per channel
+static const float KC_HI[KC_COUNT] = {
+    FLT_MAX, FLT_MAX, FLT_MAX,              // x, y, z
+    FLT_MAX, FLT_MAX, FLT_MAX,              // pitch, roll, heading
+    1.0f, FLT_MAX, 1.0f, 1.0f, 1.0f,        // gear, nws, flaps, spoilers, reversers
+    1.0f, FLT_MAX                           // thrust, rpm
+};
+
+//
+// MARK: KinEngine
+//
+
+// Allocate a slot for a new plane, returns slot index
+int KinEngine::Add ()
+{
+    if (freeSlots.empty())
+        Grow(cap ? 2*cap : KIN_MIN_CAP);
+    const int slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+// Release a slot
+void KinEngine::Remove (int slot)
+{
+    if (slot < 0 || size_t(slot) >= cap) return;
+    const size_t i = size_t(slot);
+    // A zeroed slot computes to `f = 0` and all values `0`, so it does no harm in the bulk pass
+    tsFrom[i] = invDur[i] = tsTo[i] = 0.0;
+    drOn[i] = 0;
+    for (int ch = 0; ch < KC_COUNT; ++ch)
+        base[ch][i] = delta[ch][i] = 0.0f;
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch)
+        cubA[ch][i] = cubB[ch][i] = 0.0f;
+    freeSlots.push_back(slot);
+}
+
+// Stores the from/to state of a plane, precomputes deltas
+void KinEngine::Set (int slot,
+                     const FlightData& from, const XPLMDrawInfo_t& diFrom,
+                     const FlightData& to,   const XPLMDrawInfo_t& diTo,
+                     const float* velFrom, const float* velTo)
+{
+    LOG_ASSERT(slot >= 0 && size_t(slot) < cap);
+    const size_t i = size_t(slot);
+
+    // Timing
+    tsFrom[i] = KinTime(from.ts);
+    const double dur = KinTime(to.ts) - tsFrom[i];
+    invDur[i] = dur > 0.0 ? 1.0 / dur : 0.0;
+    tsTo[i] = tsFrom[i] + dur;
+    
+    // Dead reckoning beyond `to`, on the ground we don't climb or sink
+    drOn[i]     = to.CanDeadReckon();
+    drTrack[i]  = float(deg2rad(NZ(to.track)));
+    drGs[i]     = NZ(to.gs_m);
+    drVs[i]     = to.bGnd ? 0.0f : NZ(to.vs_m);
+    drTurn[i]   = float(deg2rad(NZ(to.trackRate)));
+
+    // Values and differences, headings are turned the shortest way
+#define KIN_SET(ch,vFrom,vTo)   base[ch][i] = vFrom; delta[ch][i] = vTo - vFrom;
+#define KIN_SET_HEAD(ch,vFrom,vTo)   base[ch][i] = vFrom; delta[ch][i] = HeadDiff(vFrom, vTo);
+    KIN_SET(KC_X,               diFrom.x,       diTo.x);
+    KIN_SET(KC_Y,               diFrom.y,       diTo.y);
+    KIN_SET(KC_Z,               diFrom.z,       diTo.z);
+    KIN_SET(KC_PITCH,           diFrom.pitch,   diTo.pitch);
+    KIN_SET(KC_ROLL,            diFrom.roll,    diTo.roll);
+    KIN_SET_HEAD(KC_HEADING,    diFrom.heading, diTo.heading);
+    KIN_SET(KC_GEAR,            from.gear,      to.gear);
+    KIN_SET_HEAD(KC_NWS,        from.nws,       to.nws);
+    KIN_SET(KC_FLAPS,           from.flaps,     to.flaps);
+    KIN_SET(KC_SPOILERS,        from.spoilers,  to.spoilers);
+    KIN_SET(KC_REVERSERS,       from.reversers, to.reversers);
+    KIN_SET(KC_THRUST,          from.thrust,    to.thrust);
+    KIN_SET(KC_RPM,             from.engineRpm, to.engineRpm);
+    
+    // Cubic path: tangents are velocities scaled to the segment's duration
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch) {
+        cubA[ch][i] = velFrom && dur > 0.0 ? float(velFrom[ch] * dur) - delta[ch][i] : 0.0f;
+        cubB[ch][i] = velTo   && dur > 0.0 ? float(velTo[ch]   * dur) - delta[ch][i] : 0.0f;
+    }
+    
+    // Have output ready right away, even if this frame's bulk pass has already happened
+    ComputeSlot(i);
+}
+
+// Computes all slots' interpolated values in one pass
+void KinEngine::Compute (double now)
+{
+    lastNow = now;
+    if (!cap) return;
+
+    // _The_ factor per slot: increases from 0 to 1 while `now` is between `from` and `to` (->interpolation),
+    // and becomes larger than 1 if `now` increases even beyond `to` (-> extrapolation).
+    // Timestamps require double precision, so this is done before going to floats.
+    for (size_t i = 0; i < cap; ++i) {
+        f[i] = float((now - tsFrom[i]) * invDur[i]);
+        fCap[i] = std::min(f[i], MAX_F);
+    }
+
+    // All channels: out = f * delta + base, then clamped
+    for (int ch = 0; ch < KC_COUNT; ++ch) {
+        const float* pF = ch < KC_FIRST_CAPPED ? f.data() : fCap.data();
+        const float* pB = base[ch].data();
+        const float* pD = delta[ch].data();
+        float*       pO = out[ch].data();
+        const vfTy lo = V_SET1(KC_LO[ch]);
+        const vfTy hi = V_SET1(KC_HI[ch]);
+        for (size_t i = 0; i < cap; i += KIN_W)
+            V_STORE(pO+i, V_MIN(V_MAX(V_FMA(V_LOAD(pF+i), V_LOAD(pD+i), V_LOAD(pB+i)), lo), hi));
+    }
+    
+    // Location channels bend into the cubic path between `from` and `to`,
+    // and beyond `to` continue along its tangent instead of the straight line
+    const vfTy zero = V_SET1(0.0f);
+    const vfTy one  = V_SET1(1.0f);
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch) {
+        const float* pF = f.data();
+        const float* pA = cubA[ch].data();
+        const float* pB = cubB[ch].data();
+        float*       pO = out[ch].data();
+        for (size_t i = 0; i < cap; i += KIN_W) {
+            const vfTy s = V_MIN(V_MAX(V_LOAD(pF+i), zero), one);
+            const vfTy t = V_SUB(one, s);
+            const vfTy e = V_MAX(V_SUB(V_LOAD(pF+i), one), zero);
+            const vfTy b = V_LOAD(pB+i);
+            const vfTy c = V_SUB(V_MUL(t, V_LOAD(pA+i)), V_MUL(s, b));
+            V_STORE(pO+i, V_FMA(e, b, V_FMA(V_MUL(s, t), c, V_LOAD(pO+i))));
+        }
+    }
+    
+    // Slots beyond their `to` position follow their velocity instead of the straight line
+    for (size_t i = 0; i < cap; ++i)
+        if (drOn[i] && f[i] > 1.0f)
+            DeadReckon(i, now);
+}
+
+// Compute just one slot (scalar)
+void KinEngine::ComputeSlot (size_t i)
+{
+    f[i] = float((lastNow - tsFrom[i]) * invDur[i]);
+    fCap[i] = std::min(f[i], MAX_F);
+    for (int ch = 0; ch < KC_COUNT; ++ch)
+        out[ch][i] = std::clamp(std::fmaf(ch < KC_FIRST_CAPPED ? f[i] : fCap[i], delta[ch][i], base[ch][i]),
+                                KC_LO[ch], KC_HI[ch]);
+    const float s = std::clamp(f[i], 0.0f, 1.0f);
+    const float t = 1.0f - s;
+    const float e = std::max(f[i] - 1.0f, 0.0f);
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch)
+        out[ch][i] += s * t * (t * cubA[ch][i] - s * cubB[ch][i]) + e * cubB[ch][i];
+    if (drOn[i] && f[i] > 1.0f)
+        DeadReckon(i, lastNow);
+}
+
+// Overwrite a slot's location and heading by dead reckoning
+void KinEngine::DeadReckon (size_t i, double now)
+{
+    const float dt   = float(now - tsTo[i]);
+    const float v    = drGs[i];
+    const float w    = drTurn[i];
+    const float trk0 = drTrack[i];
+    float trk1 = trk0;
+    float dE = 0.0f, dN = 0.0f;
+    
+    // Turn along an arc, but not further than DR_MAX_TURN...
+    float tStraight = dt;
+    if (std::abs(w) > 1e-4f) {
+        const float tTurn = std::min(dt, float(deg2rad(DR_MAX_TURN)) / std::abs(w));
+        trk1 = trk0 + w * tTurn;
+        dE = v / w * (std::cos(trk0) - std::cos(trk1));
+        dN = v / w * (std::sin(trk1) - std::sin(trk0));
+        tStraight -= tTurn;
+    }
+    // ...then continue straight
+    dE += v * tStraight * std::sin(trk1);
+    dN += v * tStraight * std::cos(trk1);
+    
+    // Start at the `to` position, in local coordinates north is -z
+    out[KC_X][i]        = base[KC_X][i] + delta[KC_X][i] + dE;
+    out[KC_Y][i]        = base[KC_Y][i] + delta[KC_Y][i] + drVs[i] * dt;
+    out[KC_Z][i]        = base[KC_Z][i] + delta[KC_Z][i] - dN;
+    out[KC_HEADING][i]  = base[KC_HEADING][i] + delta[KC_HEADING][i] + float(rad2deg(trk1 - trk0));
+}
+
+// Cleanup all slots
+void KinEngine::Clear ()
+{
+    cap = 0;
+    lastNow = 0.0;
+    freeSlots.clear();
+    tsFrom.clear();
+    invDur.clear();
+    tsTo.clear();
+    drOn.clear();
+    drTrack.clear();
+    drGs.clear();
+    drVs.clear();
+    drTurn.clear();
+    f.clear();
+    fCap.clear();
+    for (int ch = 0; ch < KC_COUNT; ++ch) {
+        base[ch].clear();
+        delta[ch].clear();
+        out[ch].clear();
+    }
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch) {
+        cubA[ch].clear();
+        cubB[ch].clear();
+    }
+}
+
+// Grow all arrays to a new capacity
+void KinEngine::Grow (size_t newCap)
+{
+    // capacity is always a multiple of the vector width, so the bulk pass needs no tail handling
+    newCap = (newCap + KIN_W - 1) / KIN_W * KIN_W;
+    if (newCap <= cap) return;
+
+    tsFrom.resize(newCap, 0.0);
+    invDur.resize(newCap, 0.0);
+    tsTo.resize(newCap, 0.0);
+    drOn.resize(newCap, 0);
+    drTrack.resize(newCap, 0.0f);
+    drGs.resize(newCap, 0.0f);
+    drVs.resize(newCap, 0.0f);
+    drTurn.resize(newCap, 0.0f);
+    f.resize(newCap, 0.0f);
+    fCap.resize(newCap, 0.0f);
+    for (int ch = 0; ch < KC_COUNT; ++ch) {
+        base[ch].resize(newCap, 0.0f);
+        delta[ch].resize(newCap, 0.0f);
+        out[ch].resize(newCap, 0.0f);
+    }
+    for (int ch = 0; ch < KC_NUM_LOC; ++ch) {
+        cubA[ch].resize(newCap, 0.0f);
+        cubB[ch].resize(newCap, 0.0f);
+    }
+
+    // new slots are free, lowest index to be handed out first
+    for (size_t i = newCap; i > cap; --i)
+        freeSlots.push_back(int(i-1));
+    cap = newCap;
+}
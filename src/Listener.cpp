@@ -25,6 +25,8 @@
 #if APL == 1 || LIN == 1
 #include <unistd.h>                     // for pipe
 #include <sys/fcntl.h>                  // for F_SETFL, O_NONBLOCK
+#include <sys/socket.h>                 // for setsockopt
+#include <netinet/in.h>                 // for IP_MULTICAST_TTL
 #endif
 
 //
@@ -47,6 +49,8 @@ static XPMP2::UDPReceiver* gpUDP = nullptr;     ///< UDP receiver socket (destru
 static SOCKET gSelfPipe[2] = { INVALID_SOCKET, INVALID_SOCKET };
 #endif
 
+static void FeedbackOpen ();            // see below, called by the listener thread
+
 /// Conditions for continued receive operation
 bool ListenContinue ()
 {
@@ -63,6 +67,9 @@ void ListenMain()
     // This is a thread main function, set thread's name
     SET_THREAD_NAME(XPPLANES "_Listen");
     
+    // Resolve the producers, which want feedback, here to keep name lookups off the main thread
+    FeedbackOpen();
+    
     try {
         LOG_ASSERT(gpMc != nullptr);
         LOG_ASSERT(gpUDP != nullptr);
@@ -169,6 +176,159 @@ void ListenMain()
     glob.eStatus = GlobVars::STATUS_INACTIVE;
 }
 
+//
+// MARK: SENDING Feedback to Producers (XP Main Thread)
+//
+
+#define FEEDBACK_VERSION    1           ///< version of the feedback message format
+
+/// Sockets connected to the registered producers, set up by the listener thread, then used by the main thread
+static std::vector<std::unique_ptr<XPMP2::UDPReceiver> > gFeedbackTargets;
+/// Are `gFeedbackTargets` ready for the main thread to send?
+static std::atomic<bool> gbFeedbackReady(false);
+static std::chrono::steady_clock::time_point gFeedbackLast; ///< when feedback was sent last
+static std::vector<int> gFeedbackBands;         ///< limits of the distance bands [km], increasing
+constexpr double FEEDBACK_RECS_NEAR = 5.0;      ///< records per buffering delay asked for in the nearest band, for smooth paths
+constexpr double FEEDBACK_RECS_MIN  = 2.0;      ///< records per buffering delay asked for at least, so interpolation doesn't run out of data
+
+/// Close the feedback sockets, only while the listener thread isn't running
+static void FeedbackClose ()
+{
+    gbFeedbackReady = false;
+    for (auto& pTarget: gFeedbackTargets)
+        pTarget->Close();
+    gFeedbackTargets.clear();
+    gFeedbackBands.clear();
+}
+
+/// Listener thread: Resolve the registered producers once and connect a UDP socket to each
+static void FeedbackOpen ()
+{
+    if (glob.feedbackInterval <= 0 ||
+        glob.feedbackTargets.empty() || glob.feedbackTargets == "none")
+        return;
+    
+    // Connect to all `host:port` targets
+    StrTokens tTargets(glob.feedbackTargets, ";");
+    while (!tTargets.finished()) {
+        const std::string sTarget = tTargets.next();
+        if (sTarget.empty()) continue;
+        const std::pair<std::string,std::string> hostPort = str_split(sTarget, ":");
+        const int port = std::atoi(hostPort.second.c_str());
+        if (hostPort.first.empty() || port <= 0) {
+            LOG_MSG(logWARN, "Ignoring invalid feedback target '%s', expected 'host:port'", sTarget.c_str());
+            continue;
+        }
+        try {
+            std::unique_ptr<XPMP2::UDPReceiver> pTarget(new XPMP2::UDPReceiver());
+            pTarget->Connect(hostPort.first, port, size_t(glob.remoteBufSize));
+            // Multicast groups are reached with the configured TTL
+#if APL
+            const u_char ttl = u_char(glob.remoteTTL);
+#else
+            const int ttl = glob.remoteTTL;
+#endif
+            setsockopt(pTarget->getSocket(), IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl));
+            gFeedbackTargets.push_back(std::move(pTarget));
+        }
+        catch (const std::exception& e) {
+            LOG_MSG(logWARN, "Ignoring feedback target '%s': %s", sTarget.c_str(), e.what());
+        }
+    }
+    if (gFeedbackTargets.empty())
+        return;
+    
+    // Distance bands, each farther out asks for half the rate
+    StrTokens tBands(glob.feedbackBands, ";");
+    while (!tBands.finished()) {
+        const std::string sBand = tBands.next();
+        if (sBand.empty()) continue;
+        const int dist = std::atoi(sBand.c_str());
+        if (dist <= 0 || (!gFeedbackBands.empty() && dist <= gFeedbackBands.back())) {
+            LOG_MSG(logWARN, "Ignoring feedback band '%s', expected increasing distances in km", sBand.c_str());
+            continue;
+        }
+        gFeedbackBands.push_back(dist);
+    }
+    
+    gFeedbackLast = std::chrono::steady_clock::time_point();
+    LOG_MSG(logMSG, "Sending feedback to %lu producers every %ds",
+            (unsigned long)gFeedbackTargets.size(), glob.feedbackInterval);
+    gbFeedbackReady = true;
+}
+
+/// Compose the feedback message in JSON format
+static std::string FeedbackMessage ()
+{
+    // Ownship's position is the center of everything
+    static XPLMDataRef drLat = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef drLon = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    static XPLMDataRef drElev = XPLMFindDataRef("sim/flightmodel/position/elevation");
+    
+    // The update rate needed follows from the buffering delay: Nearby enough records
+    // for smooth paths, farther away at least enough that interpolation doesn't run out of data.
+    // More than the minimum spacing between positions would be dropped anyway.
+    const bool bOverload = PlaneMaintOverloaded();
+    double delay = glob.bBufferAdaptive ? double(FlightDataBufferDelayAvg()) : 0.0;
+    if (delay <= 0.0) delay = double(std::max(glob.bufferPeriod, 1));
+    const auto minDiffNs = std::chrono::duration_cast<std::chrono::nanoseconds>(FlightDataMinTsDiff()).count();
+    const double rateMax = minDiffNs > 0 ? 1.0e9 / double(minDiffNs) : FEEDBACK_RECS_NEAR / delay;
+    const double rateMin = std::min(FEEDBACK_RECS_MIN / delay, rateMax);
+    double rate = FEEDBACK_RECS_NEAR / delay;
+    if (bOverload) rate /= 2.0;                 // overloaded, send less
+    std::string bands;
+    char buf[256];
+    for (int dist: gFeedbackBands) {
+        if (glob.regionRadiusKm > 0 && dist >= glob.regionRadiusKm) break;
+        snprintf(buf, sizeof(buf), "{\"dist\":%d,\"rate\":%.2f},", dist,
+                 std::min(std::max(rate, rateMin), rateMax));
+        bands += buf;
+        rate /= 2.0;
+    }
+    // The last band reaches to the region's limit, or has no limit
+    rate = std::min(std::max(rate, rateMin), rateMax);
+    if (glob.regionRadiusKm > 0)
+        snprintf(buf, sizeof(buf), "{\"dist\":%d,\"rate\":%.2f}", glob.regionRadiusKm, rate);
+    else
+        snprintf(buf, sizeof(buf), "{\"dist\":null,\"rate\":%.2f}", rate);
+    bands += buf;
+    
+    // Put it all together
+    std::string msg(512 + bands.size(), '\0');
+    const int len =
+    snprintf(&msg[0], msg.size(),
+             "{\"feedback\":{\"version\":%d,"
+             "\"ownship\":{\"lat\":%.6f,\"lon\":%.6f,\"alt_geo\":%.0f},"
+             "\"radius\":%d,\"bands\":[%s],\"overload\":%s,"
+             "\"dropped\":{\"decimated\":%d,\"out_of_region\":%d,\"category\":%d,\"late\":%d}}}",
+             FEEDBACK_VERSION,
+             XPLMGetDatad(drLat), XPLMGetDatad(drLon), XPLMGetDatad(drElev) / XPMP2::M_per_FT,
+             glob.regionRadiusKm, bands.c_str(), bOverload ? "true" : "false",
+             FlightDataNumDecimated(), FlightDataNumOutOfRegion(), FlightDataNumCatDropped(),
+             FlightDataBufferUnderruns());
+    msg.resize(size_t(std::max(0, std::min(len, int(msg.size()) - 1))));
+    return msg;
+}
+
+// Sends feedback to registered producers if due
+void ListenFeedback ()
+{
+    if (!gbFeedbackReady)
+        return;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - gFeedbackLast < std::chrono::seconds(glob.feedbackInterval))
+        return;
+    gFeedbackLast = now;
+    
+    const std::string msg = FeedbackMessage();
+    for (const auto& pTarget: gFeedbackTargets) {
+        if (!pTarget->send(msg.c_str())) {
+            LOG_MSG(logDEBUG, "Couldn't send feedback to %s:%d",
+                    pTarget->getAddr().c_str(), pTarget->getPort());
+        }
+    }
+}
+
 //
 // MARK: Global public functions (XP Main Thread)
 //
@@ -201,7 +361,8 @@ bool ListenStartup ()
         gThrMC = std::thread();
     }
     
-    // Start the thread
+    // Start the thread, which also sets up feedback to producers
+    FeedbackClose();
     gThrMC = std::thread(ListenMain);
     return gThrMC.joinable();
 }
@@ -230,6 +391,7 @@ void ListenShutdown ()
         gThrMC.join();
         gThrMC = std::thread();
     }
+    FeedbackClose();
 
     // remove the networking objects
     if (gpMc) {
@@ -20,34 +20,338 @@
 
 #include "XPPlanes.h"
 
+//
+// MARK: Model Matching Cache
+//
+
+/// @brief Cache of model matching results: maps type/airline/livery to the id of the matched CSL model
+/// @details Feeds deliver the registration as livery, which is unique per aircraft and
+///          would prevent any sharing of results. So the livery is only part of the key
+///          if any installed CSL model is meant for that special livery, see MdlMatchLivery().
+///          Most recently used entries are kept at the front of the list,
+///          the map points into the list for lookup.
+static std::list<std::pair<std::string, std::string> > gMdlMatchList;
+/// Lookup into `gMdlMatchList` by key
+static std::unordered_map<std::string, decltype(gMdlMatchList)::iterator> gMdlMatchCache;
+/// Special liveries, for which installed CSL models exist
+static std::unordered_set<std::string> gMdlLiveries;
+
+/// Collect the special liveries of all installed CSL models
+static void MdlLiveriesCollect ()
+{
+    gMdlLiveries.clear();
+    const int numModels = XPMPGetNumberOfInstalledModels();
+    std::string mdlName, icaoType, icaoAirline, livery;
+    for (int i = 0; i < numModels; ++i) {
+        XPMPGetModelInfo2(i, mdlName, icaoType, icaoAirline, livery);
+        if (!livery.empty())
+            gMdlLiveries.insert(livery);
+    }
+    LOG_MSG(logDEBUG, "%lu special liveries found in %d CSL models",
+            (unsigned long)gMdlLiveries.size(), numModels);
+}
+
+// The livery as far as it influences model matching, empty if no CSL model exists for it
+const std::string& MdlMatchLivery (const std::string& livery)
+{
+    static const std::string noLivery;
+    return livery.empty() || !gMdlLiveries.count(livery) ? noLivery : livery;
+}
+
+/// Key into the model matching cache
+static std::string MdlMatchKey (const std::string& type, const std::string& airline,
+                                const std::string& livery)
+{
+    const std::string& mdlLivery = MdlMatchLivery(livery);
+    std::string key;
+    key.reserve(type.size() + airline.size() + mdlLivery.size() + 2);
+    key  = type;
+    key += '|';
+    key += airline;
+    key += '|';
+    key += mdlLivery;
+    return key;
+}
+
+// Find a previous model matching result, returns empty string if not found
+std::string MdlMatchLookup (const std::string& type, const std::string& airline,
+                            const std::string& livery)
+{
+    auto iter = gMdlMatchCache.find(MdlMatchKey(type, airline, livery));
+    if (iter == gMdlMatchCache.end())
+        return std::string();
+    // move to the front as most recently used
+    gMdlMatchList.splice(gMdlMatchList.begin(), gMdlMatchList, iter->second);
+    return iter->second->second;
+}
+
+// Store a model matching result
+void MdlMatchStore (const std::string& type, const std::string& airline,
+                    const std::string& livery, const std::string& cslId)
+{
+    if (cslId.empty()) return;
+    std::string key = MdlMatchKey(type, airline, livery);
+    auto iter = gMdlMatchCache.find(key);
+    if (iter != gMdlMatchCache.end()) {
+        iter->second->second = cslId;
+        gMdlMatchList.splice(gMdlMatchList.begin(), gMdlMatchList, iter->second);
+        return;
+    }
+    // evict the least recently used entry if full
+    if (gMdlMatchCache.size() >= MDL_MATCH_CACHE_MAX) {
+        gMdlMatchCache.erase(gMdlMatchList.back().first);
+        gMdlMatchList.pop_back();
+    }
+    gMdlMatchList.emplace_front(std::move(key), cslId);
+    gMdlMatchCache.emplace(gMdlMatchList.front().first, gMdlMatchList.begin());
+}
+
+//
+// MARK: Pending Work
+//
+
+/// A plane reaching its `to` position at the given time
+typedef std::pair<tsTy,XPMPPlaneID> PlaneDueTy;
+/// Planes by the time they reach their `to` position, earliest first (outdated entries are skipped when due)
+static std::priority_queue<PlaneDueTy, std::vector<PlaneDueTy>, std::greater<PlaneDueTy> > gDueQueue;
+/// Planes, which have reached their `to` position and wait for fresh data
+static std::unordered_set<XPMPPlaneID> gDueIds;
+/// Aircraft with fresh data, which couldn't be processed yet within the budget
+static std::unordered_set<XPMPPlaneID> gMaintDirty;
+/// Planes with a deferred model change, see Plane::ApplyModelChange()
+static std::unordered_set<XPMPPlaneID> gMdlChangeIds;
+/// Planes with provisional ground altitudes, see Plane::ResolveGndAlt()
+static std::unordered_set<XPMPPlaneID> gGndAltIds;
+
+/// A plane is removed, so it has no more pending work
+static void PlanePendingForget (XPMPPlaneID id)
+{
+    gDueIds.erase(id);
+    gMdlChangeIds.erase(id);
+    gGndAltIds.erase(id);
+}
+
+/// Forget all pending work
+static void PlanePendingClear ()
+{
+    gDueQueue = decltype(gDueQueue)();
+    gDueIds.clear();
+    gMaintDirty.clear();
+    gMdlChangeIds.clear();
+    gGndAltIds.clear();
+}
+
+//
+// MARK: Recycle Pool
+//
+
+/// A parked plane waiting to be reused
+struct PlanePoolEntryTy {
+    mapPlanesTy::node_type  node;   ///< map node owning the plane, can be re-inserted into `glob.mapPlanes` under a new key
+    std::chrono::steady_clock::time_point tsParked; ///< when was the plane parked?
+};
+
+/// Parked planes, oldest first
+static std::deque<PlanePoolEntryTy> gPool;
+/// Number of planes reused from the pool
+static int gNumRecycled = 0;
+/// Number of label rebuilds, i.e. updates with changed label-defining fields
+static int gNumLabelRebuilds = 0;
+/// Number of updates, which reused the existing label
+static int gNumLabelReused = 0;
+
+/// @brief Remove a plane from `glob.mapPlanes` and park it in the recycle pool
+/// @return Iterator to the next plane in `glob.mapPlanes`
+static mapPlanesTy::iterator PlanePark (mapPlanesTy::iterator iPlane)
+{
+    PlanePendingForget(iPlane->first);
+    
+    // Pooling switched off? Then just destroy the plane
+    if (glob.recyclePoolSize <= 0)
+        return glob.mapPlanes.erase(iPlane);
+    
+    auto iNext = std::next(iPlane);
+    gPool.push_back({ glob.mapPlanes.extract(iPlane), std::chrono::steady_clock::now() });
+    gPool.back().node.mapped().Park();
+    // Pool too large? Then the oldest goes for good
+    while (gPool.size() > size_t(glob.recyclePoolSize))
+        gPool.pop_front();
+    return iNext;
+}
+
+/// Destroy parked planes which waited too long for reuse
+static void PlanePoolExpire ()
+{
+    const auto tsCutOff = std::chrono::steady_clock::now() - std::chrono::seconds(glob.recycleTime);
+    while (!gPool.empty() && gPool.front().tsParked < tsCutOff)
+        gPool.pop_front();
+}
+
+/// @brief Find a parked plane for reuse, preferrably the same aircraft, otherwise one with the same model
+/// @details Same model means: Same type/airline (and special livery, if any),
+///          or the CSL model, which a previous match for this kind of aircraft resolved to
+/// @return Iterator into `gPool`, or `gPool.end()` if none found
+static std::deque<PlanePoolEntryTy>::iterator PlanePoolFind (const FlightData& fd)
+{
+    const std::string cslId = MdlMatchLookup(fd.icaoType, fd.icaoAirline, fd.tailNum);
+    auto iSameMdl = gPool.end();
+    for (auto iter = gPool.begin(); iter != gPool.end(); ++iter) {
+        const Plane& plane = iter->node.mapped();
+        if (iter->node.key() == fd._modeS_id)
+            return iter;
+        if (iSameMdl == gPool.end() &&
+            (plane.IsSameModel(fd.icaoType, fd.icaoAirline, fd.tailNum) ||
+             (!cslId.empty() && plane.GetModelName() == cslId)))
+            iSameMdl = iter;
+    }
+    return iSameMdl;
+}
+
+//
+// MARK: Creation Queue
+//
+
+/// A plane waiting to be created
+struct PlaneCreateReqTy {
+    XPMPPlaneID     id = 0;         ///< plane's id
+    ptrFlightDataTy from;           ///< first position
+    ptrFlightDataTy to;             ///< second position
+};
+
+/// Planes waiting to be created, in order of arrival
+static std::deque<PlaneCreateReqTy> gCreateQueue;
+/// Ids of the planes in `gCreateQueue`
+static std::unordered_set<XPMPPlaneID> gCreateIds;
+
+static bool PlaneMustDemote (XPMPPlaneID id);
+
+/// Average time from receiving an aircraft's first data to displaying it [s]
+static float gTimeToDisplay = 0.0f;
+
+/// Record the time from receiving the first data to displaying the plane
+static void PlaneTimeToDisplayAdd (const FlightData& fdFirst)
+{
+    // (restored snapshot data has no reception time)
+    if (fdFirst.tsRcvd == std::chrono::steady_clock::time_point())
+        return;
+    const float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - fdFirst.tsRcvd).count();
+    gTimeToDisplay = gTimeToDisplay > 0.0f ? std::fmaf(TTFD_SMOOTHING, t - gTimeToDisplay, gTimeToDisplay) : t;
+}
+
+/// Create up to `glob.maxCreatePerCycle` queued planes, must not be called with `glob.mtxListFD` locked
+static void PlaneCreateQueued (const tsTy& cutOff)
+{
+    for (int n = 0; n < glob.maxCreatePerCycle && !gCreateQueue.empty(); )
+    {
+        PlaneCreateReqTy req = std::move(gCreateQueue.front());
+        gCreateQueue.pop_front();
+        gCreateIds.erase(req.id);
+        
+        // waited too long in the queue? Or no longer near enough?
+        if (req.to->ts < cutOff || PlaneMustDemote(req.id))
+            continue;
+        
+        PlaneTimeToDisplayAdd(*req.from);
+        
+        // Can we reuse a parked plane?
+        auto iPool = PlanePoolFind(*req.from);
+        if (iPool != gPool.end()) {
+            mapPlanesTy::node_type node = std::move(iPool->node);
+            gPool.erase(iPool);
+            node.key() = req.id;
+            node.mapped().Recycle(std::move(req.from), std::move(req.to));
+            glob.mapPlanes.insert(std::move(node));
+            ++gNumRecycled;
+            continue;                       // doesn't count as creation, it's cheap
+        }
+        
+        // create the plane with those two starting positions
+        glob.mapPlanes.emplace(std::piecewise_construct,
+                               std::forward_as_tuple(req.id),
+                               std::forward_as_tuple(std::move(req.from), std::move(req.to)));
+        ++n;
+    }
+}
+
+//
+// MARK: Tiers
+//
+
+/// Ids of aircraft, which may become full planes (the nearest `glob.maxFullPlanes`)
+static std::unordered_set<XPMPPlaneID> gTierPromote;
+/// Ids of aircraft, which may stay full planes (includes the hysteresis margin)
+static std::unordered_set<XPMPPlaneID> gTierKeep;
+
+/// Is tiering active, ie. is the number of full planes limited?
+inline bool PlaneTiersActive () { return glob.maxFullPlanes > 0; }
+
+/// Hard cap of full planes: configured maximum plus hysteresis margin
+inline size_t PlaneTiersCap ()
+{ return size_t(glob.maxFullPlanes) + std::max<size_t>(TIER_HYST_MIN, size_t(glob.maxFullPlanes) / TIER_HYST_DIV); }
+
+/// Determine which aircraft are near enough to the camera to be (or stay) full planes
+static void PlaneDetermineTiers ()
+{
+    gTierPromote.clear();
+    gTierKeep.clear();
+    if (!PlaneTiersActive()) return;
+    
+    XPLMCameraPosition_t cam;
+    XPLMReadCameraPosition(&cam);
+    static vecSpatialHitTy hits;
+    glob.spatial.Nearest(cam.x, cam.z, PlaneTiersCap(), hits);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        if (i < size_t(glob.maxFullPlanes))
+            gTierPromote.insert(hits[i].id);
+        gTierKeep.insert(hits[i].id);
+    }
+}
+
+/// May a full plane be created for the given aircraft?
+static bool PlaneMayPromote (XPMPPlaneID id)
+{
+    return
+    !PlaneTiersActive() ||
+    (gTierPromote.count(id) > 0 &&
+     glob.mapPlanes.size() + gCreateQueue.size() < PlaneTiersCap());
+}
+
+/// Must the given full plane be demoted to a lightweight record?
+static bool PlaneMustDemote (XPMPPlaneID id)
+{
+    return PlaneTiersActive() && !gTierKeep.count(id);
+}
+
 //
 // MARK: Process Flight Data
 //
 
+/// Did the last plane maintenance exceed its budget?
+static bool gMaintOverloaded = false;
+
 void PlaneMaintenance ()
 {
-    // *** Prepare for filtering ownship data ***
-    static XPLMDataRef drModeSId = XPLMFindDataRef("sim/aircraft/view/acf_modeS_id");
-    static XPLMDataRef drTailNum = XPLMFindDataRef("sim/aircraft/view/acf_tailnum");
-    XPMPPlaneID osId = 0;
-    char osTail[41] = "";
-    // ID of the plane that has "our" tail number: Tail number is optional, so not always send in.
-    // We store the ID of the plane once we have a matching tail so we can match against later data again.
-    static XPMPPlaneID osIdFromTail = 0;
+    // *** Time budget ***
+    const auto tStart = std::chrono::steady_clock::now();
+    const auto tEnd = tStart + std::chrono::microseconds(glob.maintBudget);
     
-    if (drModeSId && glob.ShallHideOsById())                        // compare by ADS-B hex id?
-        osId = (XPMPPlaneID)XPLMGetDatai(drModeSId);                // read ownship's hex id
-    if (drTailNum && glob.ShallHideOsByReg()) {                     // compare by tail number / regsitration?
-        XPLMGetDatab(drTailNum, osTail, 0, sizeof(osTail)-1);       // read ownship tail number
-        osTail[sizeof(osTail)-1] = 0;                               // ensure zero-termination
-    }
+    // *** Make sure local coordinates are based on the current reference point ***
+    if (ProjUpdateRef())
+        Plane::RebaseAll();
+    
+    // *** Prepare for filtering ownship data ***
+    FlightDataReadOwnship();                                        // the network thread then drops ownship's and far away data
     
     // *** Update from FlightData lists***
     tsTy now = std::chrono::system_clock::now();
     tsTy cutOff = now - std::chrono::seconds(glob.gracePeriod);
     
+    // Which aircraft are near enough to be full planes?
+    PlaneDetermineTiers();
+    
     // Loop over map/list of flight data and see if we need to create or update planes
     bool bHaveData = false;
+    std::vector<XPMPPlaneID> vecPark;                       // expired planes to be parked
     {
         std::lock_guard<std::mutex> guard(glob.mtxListFD);          // guarded by a mutex so that network thread doesn't update
 
@@ -56,9 +360,31 @@ void PlaneMaintenance ()
             glob.eStatus = GlobVars::STATUS_ACTIVE;
             LOG_MSG(logINFO, "Status turned ACTIVE");
         }
+        
+        // First, planes which have reached their `to` position need fresh data right away, independend of budget:
+        // those, which just became due, and those already waiting, for which data arrived
+        static std::vector<XPMPPlaneID> vecDue;
+        vecDue.clear();
+        for (; !gDueQueue.empty() && gDueQueue.top().first <= now; gDueQueue.pop())
+            vecDue.push_back(gDueQueue.top().second);
+        for (const XPMPPlaneID id: glob.setDirtyFD)
+            if (gDueIds.count(id))
+                vecDue.push_back(id);
+        for (const XPMPPlaneID id: vecDue) {
+            auto iPlane = glob.mapPlanes.find(id);
+            if (iPlane != glob.mapPlanes.end() && iPlane->second.NeedsNewData(now)) {
+                auto iPlaneFD = glob.mapListFD.find(id);
+                if (iPlaneFD != glob.mapListFD.end())
+                    iPlane->second.UpdateFromFlightData(iPlaneFD->second, now);
+            }
+            if (iPlane != glob.mapPlanes.end() && iPlane->second.NeedsNewData(now))
+                gDueIds.insert(id);                         // still waiting for data
+            else
+                gDueIds.erase(id);
+        }
 
-        for (auto iPlaneFD = glob.mapListFD.begin();
-             iPlaneFD != glob.mapListFD.end();)
+        // Processing of one aircraft's flight data, returns iterator to the next entry
+        auto MaintainEntry = [&](mapListFlightDataTy::iterator iPlaneFD) -> mapListFlightDataTy::iterator
         {
             // Remove outdated data from the list just to make sure we clean up properly
             listFlightDataTy& listFd = iPlaneFD->second;
@@ -67,29 +393,14 @@ void PlaneMaintenance ()
             
             // if there is no data then remove the plane's entry
             if (iPlaneFD->second.empty()) {
-                iPlaneFD = glob.mapListFD.erase(iPlaneFD);
-                continue;
+                if (!glob.mapPlanes.count(iPlaneFD->first) && !gCreateIds.count(iPlaneFD->first))
+                    glob.spatial.Remove(iPlaneFD->first);   // a lightweight record vanishes
+                return glob.mapListFD.erase(iPlaneFD);
             }
             
-            // Scan for tail number if we hide ownship based on tail
-            if (osTail[0]) for (const ptrFlightDataTy& fd: iPlaneFD->second) {
-                if (fd->tailNum == osTail) {
-                    if (osIdFromTail != iPlaneFD->first) {      // is this a change?
-                        LOG_MSG(logDEBUG, "Identified ownship by tail '%s' to be id 0x%06X",
-                                osTail, iPlaneFD->first);
-                    }
-                    osIdFromTail = iPlaneFD->first;
-                    break;
-                }
-            }
-            
-            // Ignore ownship data? (either based on modeS_id or based on tail
-            if ((osId &&         iPlaneFD->first == osId) ||
-                (osIdFromTail && iPlaneFD->first == osIdFromTail)) {
-                // remove plane's data and continue with next plane
-                iPlaneFD = glob.mapListFD.erase(iPlaneFD);
-                continue;
-            }
+            // The aircraft expires a grace period after its youngest data
+            glob.expiry.Schedule(iPlaneFD->first,
+                                 iPlaneFD->second.back()->ts + std::chrono::seconds(glob.gracePeriod));
             
             // Is there already a matching plane?
             try {
@@ -97,41 +408,183 @@ void PlaneMaintenance ()
                 plane.UpdateFromFlightData(iPlaneFD->second, now);
             }
             catch (const std::out_of_range&) {
-                // there is no such plane yet, do we have enough data to create one?
-                if (iPlaneFD->second.size() >= 2) {
-                    // fetch the two starting position from the list
-                    ptrFlightDataTy from = std::move(iPlaneFD->second.front());
-                    iPlaneFD->second.pop_front();
-                    ptrFlightDataTy to = std::move(iPlaneFD->second.front());
-                    iPlaneFD->second.pop_front();
-                    // and create a plane with those
-                    glob.mapPlanes.emplace(std::piecewise_construct,
-                                           std::forward_as_tuple(iPlaneFD->first),
-                                           std::forward_as_tuple(std::move(from), std::move(to)));
+                // there is no such plane (yet), so it is a lightweight record only:
+                // keep its position in the spatial index current so it can be promoted when near
+                const FlightData& fdLast = *iPlaneFD->second.back();
+                double x = 0.0, y = 0.0, z = 0.0;
+                ProjWorldToLocal(fdLast.lat, fdLast.lon, NZ(fdLast.alt_m), x, y, z);
+                glob.spatial.Update(iPlaneFD->first, float(x), float(z));
+                
+                // do we have enough data to create one, and is it near enough?
+                // (a single record will do if it has track and speed, then we dead-reckon where it is now)
+                if ((iPlaneFD->second.size() >= 2 || iPlaneFD->second.front()->CanDeadReckon()) &&
+                    !gCreateIds.count(iPlaneFD->first) &&
+                    PlaneMayPromote(iPlaneFD->first))
+                {
+                    PlaneCreateReqTy req;
+                    req.id = iPlaneFD->first;
+                    if (iPlaneFD->second.size() >= 2) {
+                        // fetch the two starting position from the list
+                        req.from = std::move(iPlaneFD->second.front());
+                        iPlaneFD->second.pop_front();
+                        req.to = std::move(iPlaneFD->second.front());
+                        iPlaneFD->second.pop_front();
+                    } else {
+                        // the one record we have becomes `to`, `from` is where the plane is right now
+                        req.to = std::move(iPlaneFD->second.front());
+                        iPlaneFD->second.pop_front();
+                        req.from = req.to->DeadReckon(std::min(now, req.to->ts - SPAWN_DR_MIN_DIFF));
+                    }
+                    // and queue the plane for creation outside the lock
+                    gCreateIds.insert(req.id);
+                    gCreateQueue.emplace_back(std::move(req));
+                }
+            }
+            
+            return std::next(iPlaneFD);
+        };
+        
+        // Then, aircraft which received data since last time,
+        // until the budget is used up (but always processing a minimum number of entries)
+        gMaintDirty.insert(glob.setDirtyFD.begin(), glob.setDirtyFD.end());
+        glob.setDirtyFD.clear();
+        size_t nDone = 0;
+        for (auto iDirty = gMaintDirty.begin();
+             iDirty != gMaintDirty.end();
+             iDirty = gMaintDirty.erase(iDirty), ++nDone)
+        {
+            // Budget used up? Remaining ones stay dirty for next time
+            if (nDone >= MAINT_MIN_ENTRIES && std::chrono::steady_clock::now() >= tEnd)
+                break;
+            auto iPlaneFD = glob.mapListFD.find(*iDirty);
+            if (iPlaneFD != glob.mapListFD.end())
+                MaintainEntry(iPlaneFD);
+        }
+        
+        // Lightweight records, which are now near enough to be full planes, are reconsidered
+        // even without fresh data (at most `glob.maxFullPlanes`, and mostly full planes already)
+        for (const XPMPPlaneID id: gTierPromote) {
+            if (glob.mapPlanes.count(id) || gCreateIds.count(id))
+                continue;
+            auto iPlaneFD = glob.mapListFD.find(id);
+            if (iPlaneFD != glob.mapListFD.end())
+                MaintainEntry(iPlaneFD);
+        }
+        
+        // Finally, aircraft whose deadline has passed: only these are looked at for cleanup
+        std::vector<XPMPPlaneID> vecExpired;
+        glob.expiry.Advance(now, vecExpired);
+        for (const XPMPPlaneID id: vecExpired) {
+            // Remove outdated data, there might still be younger data left
+            auto iPlaneFD = glob.mapListFD.find(id);
+            if (iPlaneFD != glob.mapListFD.end()) {
+                listFlightDataTy& listFd = iPlaneFD->second;
+                while (!listFd.empty() && listFd.front()->ts < cutOff)
+                    listFd.pop_front();
+                if (!listFd.empty()) {                      // (deadline had been extended in the meantime)
+                    glob.expiry.Schedule(id, listFd.back()->ts + std::chrono::seconds(glob.gracePeriod));
+                    continue;
                 }
+                glob.mapListFD.erase(iPlaneFD);
             }
+            FlightDataForget(id);                           // no more data, forget its timing, track, and category
             
-            // next entry
-            ++iPlaneFD;
+            // Does the plane itself say it's outdated?
+            auto iPlane = glob.mapPlanes.find(id);
+            if (iPlane != glob.mapPlanes.end()) {
+                if (iPlane->second.ShallBeRemoved(cutOff))
+                    vecPark.push_back(id);                  // park outside the lock
+                else
+                    glob.expiry.Schedule(id, iPlane->second.GetToTs() + std::chrono::seconds(glob.gracePeriod));
+            }
+            else if (gCreateIds.count(id))                  // still waiting for creation, look again later
+                glob.expiry.Schedule(id, now + std::chrono::seconds(glob.gracePeriod));
+            else
+                glob.spatial.Remove(id);                    // a lightweight record vanishes
         }
     }
     
-    // *** Remove planes that say so ***
-    now -= std::chrono::seconds(glob.gracePeriod);       // deduct grace period
-    for (auto iPlane = glob.mapPlanes.begin();
-         iPlane != glob.mapPlanes.end();)
-    {
-        if (glob.eStatus == GlobVars::STATUS_INACTIVE ||    // remove all planes if (turned) inactive
-            iPlane->second.ShallBeRemoved(now))             // or if plane itself says so
-            iPlane = glob.mapPlanes.erase(iPlane);
+    // *** Create queued planes and apply model changes, both outside the lock as model matching is expensive ***
+    PlaneCreateQueued(cutOff);
+    for (const XPMPPlaneID id: gMdlChangeIds) {
+        auto iPlane = glob.mapPlanes.find(id);
+        if (iPlane != glob.mapPlanes.end())
+            iPlane->second.ApplyModelChange();
+    }
+    gMdlChangeIds.clear();
+    
+    // *** Budget monitoring ***
+    // If we are over budget even though only the mandatory work was done, then we are
+    // overloaded: log a warning in regular intervals. We degrade gracefully as
+    // processing of fresh data is reduced to its minimum, so updates of existing planes go first.
+    static int nOverBudget = 0;
+    gMaintOverloaded = std::chrono::steady_clock::now() > tEnd;
+    if (gMaintOverloaded) {
+        if (++nOverBudget >= MAINT_WARN_OVER_BUDGET) {
+            LOG_MSG(logWARN, "Plane maintenance exceeded its budget of %dus in %d consecutive flight loops, last one took %ldus with %lu planes and %lu data entries",
+                    glob.maintBudget, nOverBudget,
+                    (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tStart).count(),
+                    (unsigned long)glob.mapPlanes.size(), (unsigned long)glob.mapListFD.size());
+            nOverBudget = 0;
+        }
+    }
+    else
+        nOverBudget = 0;
+    
+    // *** Probe terrain within budget, then correct provisional ground altitudes ***
+    TerrainProcessQueue();
+    for (auto iGnd = gGndAltIds.begin(); iGnd != gGndAltIds.end();) {
+        auto iPlane = glob.mapPlanes.find(*iGnd);
+        if (iPlane == glob.mapPlanes.end() || !iPlane->second.ResolveGndAlt())
+            iGnd = gGndAltIds.erase(iGnd);
         else
-            ++iPlane;
+            ++iGnd;
+    }
+    
+    // *** Remove planes that expired ***
+    for (const XPMPPlaneID id: vecPark) {                   // park them for reuse
+        auto iPlane = glob.mapPlanes.find(id);
+        if (iPlane != glob.mapPlanes.end())
+            PlanePark(iPlane);
+    }
+    size_t nDemoted = 0;
+    if (glob.eStatus == GlobVars::STATUS_INACTIVE) {        // remove all planes if (turned) inactive
+        glob.mapPlanes.clear();
+        PlanePendingClear();
+        gPool.clear();
+        glob.expiry.Clear();
+    }
+    else {
+        // Demotion looks at all planes, but only with tiers active, which limits them to PlaneTiersCap()
+        if (PlaneTiersActive()) {
+            for (auto iPlane = glob.mapPlanes.begin();
+                 iPlane != glob.mapPlanes.end();)
+            {
+                if (PlaneMustDemote(iPlane->first)) {       // too far away to stay a full plane?
+                    // the plane goes, but its position stays in the spatial index as a lightweight record
+                    const XPMPPlaneID id = iPlane->first;
+                    const float x = iPlane->second.drawInfo.x;
+                    const float z = iPlane->second.drawInfo.z;
+                    iPlane = PlanePark(iPlane);
+                    glob.spatial.Update(id, x, z);
+                    ++nDemoted;
+                }
+                else
+                    ++iPlane;
+            }
+        }
+        PlanePoolExpire();
+    }
+    if (nDemoted) {
+        LOG_MSG(logDEBUG, "%lu planes demoted to lightweight records, %lu full planes remain",
+                (unsigned long)nDemoted, (unsigned long)glob.mapPlanes.size());
     }
     
     // if there are neither planes nor data we should probably be waiting
     if (glob.eStatus == GlobVars::STATUS_ACTIVE &&
         !bHaveData &&
-        glob.mapPlanes.empty())
+        glob.mapPlanes.empty() &&
+        gCreateQueue.empty())
     {
         glob.eStatus = GlobVars::STATUS_WAITING;
         LOG_MSG(logINFO, "Status turned back to WAITING");
@@ -144,7 +597,10 @@ void Plane::UpdateFromFlightData (listFlightDataTy& listFD,
                                   const tsTy& now)
 {
     // Younger data needs to have a ts larger than this CutOff time
-    const auto tsCutOff = fdTo->ts + MIN_TS_DIFF;
+    const auto tsCutOff = fdTo->ts + FlightDataMinTsDiff();
+    bool bChanged = false;
+    int nShifted = 0;
+    const float velPrev[3] = { velTo[0], velTo[1], velTo[2] };
     // Loop all flight data (sorted), from the oldest to the newest:
     for (auto iFD = listFD.begin();
          iFD != listFD.end();)
@@ -175,18 +631,183 @@ void Plane::UpdateFromFlightData (listFlightDataTy& listFD,
             // that avoids any sudden jumping of the plane
             if (fdTo->ts > now) {
                 diFrom = drawInfo;                  // current position
-                XPLMLocalToWorld(diFrom.x, diFrom.y, diFrom.y,
-                                 &fdFrom->lat, &fdFrom->lon, &fdFrom->alt_m);
+                ProjLocalToWorld(diFrom.x, diFrom.y - GetVertOfs(), diFrom.z,
+                                 fdFrom->lat, fdFrom->lon, fdFrom->alt_m);
                 fdFrom->ts = now;                   // as of right now
             }
             
             // Remove the object from the list
             // and continue in the loop...maybe that just added data is already outdated...?
             iFD = listFD.erase(iFD);
+            bChanged = true;
+            ++nShifted;
+        }
+    }
+    
+    // Inform the kinematics engine about the new from/to state
+    if (bChanged) {
+        // The path joins the previous one smoothly if we moved on by exactly one record
+        const FlightData* pNext = nullptr;
+        for (const ptrFlightDataTy& pFD: listFD)
+            if (pFD->ts > fdTo->ts) {
+                pNext = pFD.get();
+                break;
+            }
+        CalcPathVel(nShifted == 1 ? velPrev : nullptr, pNext);
+        KinUpdate();
+    }
+}
+
+// Perform a deferred model change, using previous matching results if available
+void Plane::ApplyModelChange ()
+{
+    if (!bMdlChangePending) return;
+    bMdlChangePending = false;
+    
+    const std::string cslId = MdlMatchLookup(mdlIcaoType, mdlIcaoAirline, mdlLivery);
+    if (cslId.empty() || !AssignModel(cslId)) {
+        ChangeModel(mdlIcaoType, mdlIcaoAirline, mdlLivery);
+        MdlMatchStore(mdlIcaoType, mdlIcaoAirline, mdlLivery, GetModelName());
+    }
+}
+
+// Was the current model requested for this type, airline, and livery?
+bool Plane::IsSameModel (const std::string& type, const std::string& airline, const std::string& livery) const
+{
+    return mdlIcaoType == type && mdlIcaoAirline == airline &&
+           MdlMatchLivery(mdlLivery) == MdlMatchLivery(livery);
+}
+
+// Park the plane for later reuse: hide it and release per-plane resources
+void Plane::Park ()
+{
+    SetVisible(false);
+    glob.kin.Remove(kinIdx);
+    kinIdx = -1;
+    glob.spatial.Remove(modeS_id);
+}
+
+// Reuse a parked plane for (potentially) another aircraft
+void Plane::Recycle (ptrFlightDataTy&& from, ptrFlightDataTy&& to)
+{
+    // New identity, forget everything derived from previous data
+    SetModeS_ID(from->_modeS_id);
+    labelKey = 0;
+    f = 0.5f;
+    tTouchDown = NAN;
+    SetTouchDown(false);
+    elapsedSinceDetail = 0.0f;
+    
+    // Model needs changing if the new aircraft's initial model differs,
+    // unless a previous match for this kind of aircraft resolved to the model we already have
+    if (!IsSameModel(from->icaoType, from->icaoAirline, from->tailNum)) {
+        mdlIcaoType     = from->icaoType;
+        mdlIcaoAirline  = from->icaoAirline;
+        mdlLivery       = from->tailNum;
+        if (MdlMatchLookup(mdlIcaoType, mdlIcaoAirline, mdlLivery) != GetModelName())
+            bMdlChangePending = true;
+    }
+    if (bMdlChangePending)                      // (could also be left over from before parking)
+        gMdlChangeIds.insert(GetModeS_ID());
+    
+    // Take over the flight data
+    TakeOverData(true,  std::move(from));
+    TakeOverData(false, std::move(to));
+    
+    // Register with the kinematics engine and show again
+    kinIdx = glob.kin.Add();
+    CalcPathVel(nullptr, nullptr);
+    KinUpdate();
+    SetVisible(true);
+}
+
+// Velocity as given by a record, in local coordinates
+static bool PlaneRecordVel (const FlightData& fd, float vel[3])
+{
+    if (!fd.CanDeadReckon()) return false;
+    const float trk = float(deg2rad(fd.track));
+    vel[0] =  fd.gs_m * std::sin(trk);                  // east is +x
+    vel[1] =  fd.bGnd ? 0.0f : NZ(fd.vs_m);
+    vel[2] = -fd.gs_m * std::cos(trk);                  // north is -z
+    return true;
+}
+
+// Determine the path tangents at `from` and `to`
+void Plane::CalcPathVel (const float* velPrev, const FlightData* pNext)
+{
+    const float dur = std::chrono::duration<float>(fdTo->ts - fdFrom->ts).count();
+    const float chord[3] = {
+        dur > 0.0f ? (diTo.x - diFrom.x) / dur : 0.0f,
+        dur > 0.0f ? (diTo.y - diFrom.y) / dur : 0.0f,
+        dur > 0.0f ? (diTo.z - diFrom.z) / dur : 0.0f,
+    };
+    
+    // At `from`: given velocity, or the previous path's tangent for a smooth join, or the straight line
+    if (!PlaneRecordVel(*fdFrom, velFrom))
+        for (int i = 0; i < 3; ++i)
+            velFrom[i] = velPrev ? velPrev[i] : chord[i];
+    
+    // At `to`: given velocity, or the Catmull-Rom tangent from `from` to the next record, or the straight line
+    if (!PlaneRecordVel(*fdTo, velTo)) {
+        const float durNext = pNext ? std::chrono::duration<float>(pNext->ts - fdFrom->ts).count() : 0.0f;
+        if (durNext > dur) {
+            double x = 0.0, y = 0.0, z = 0.0;
+            ProjWorldToLocal(pNext->lat, pNext->lon, NZ(pNext->alt_m), x, y, z);
+            velTo[0] = (float(x) - diFrom.x) / durNext;
+            velTo[1] = fdTo->bGnd || std::isnan(pNext->alt_m) ? chord[1] :
+                       (float(y) + GetVertOfs() - diFrom.y) / durNext;
+            velTo[2] = (float(z) - diFrom.z) / durNext;
         }
+        else
+            for (int i = 0; i < 3; ++i)
+                velTo[i] = chord[i];
     }
 }
 
+// Pass current from/to state on to the kinematics engine
+void Plane::KinUpdate ()
+{
+    const bool bSmooth = glob.bSmoothPath && !bLight;
+    glob.kin.Set(kinIdx, *fdFrom, diFrom, *fdTo, diTo,
+                 bSmooth ? velFrom : nullptr,
+                 bSmooth ? velTo   : nullptr);
+    bStationary = IsStationary();
+    bSleeping = false;
+}
+
+// Are `from` and `to` identical, so that there is nothing to animate?
+bool Plane::IsStationary () const
+{
+    // (practically) equal values, with undefined values being equal, too
+    auto Same = [](float a, float b) { return std::isnan(a) ? std::isnan(b) : std::abs(a - b) < 0.001f; };
+    const FlightData& from = *fdFrom;
+    const FlightData& to   = *fdTo;
+    return
+    // position and attitude
+    std::abs(diTo.x - diFrom.x) <= SLEEP_MAX_DIST_M &&
+    std::abs(diTo.y - diFrom.y) <= SLEEP_MAX_DIST_M &&
+    std::abs(diTo.z - diFrom.z) <= SLEEP_MAX_DIST_M &&
+    std::abs(diTo.pitch - diFrom.pitch) <= SLEEP_MAX_ANGLE &&
+    std::abs(diTo.roll - diFrom.roll) <= SLEEP_MAX_ANGLE &&
+    std::abs(HeadDiff(diFrom.heading, diTo.heading)) <= SLEEP_MAX_ANGLE &&
+    // configuration
+    Same(from.gear, to.gear) && Same(from.nws, to.nws) &&
+    Same(from.flaps, to.flaps) && Same(from.spoilers, to.spoilers) &&
+    Same(from.reversers, to.reversers) && Same(from.thrust, to.thrust) &&
+    // not moving according to ground speed either, which dead reckoning would follow
+    !(to.gs_m > 0.0f) &&
+    // engines/props must not turn as that needs animation
+    !(from.engineRpm > 0.0f) && !(to.engineRpm > 0.0f) &&
+    // visibility and lights
+    from.bVisDefined == to.bVisDefined && from.bVisible == to.bVisible &&
+    from.lights.defined == to.lights.defined &&
+    from.lights.taxi    == to.lights.taxi    &&
+    from.lights.landing == to.lights.landing &&
+    from.lights.beacon  == to.lights.beacon  &&
+    from.lights.strobe  == to.lights.strobe  &&
+    from.lights.nav     == to.lights.nav;
+}
+
 // Prepare given position for usage after taking over from passed-in smart pointer
 void Plane::TakeOverData (bool bFrom, ptrFlightDataTy&& source)
 {
@@ -201,76 +822,73 @@ void Plane::TakeOverData (bool bFrom, ptrFlightDataTy&& source)
     else                                        // In all future updates we keep the current value stable if no new value arrives
         fd->NANtoCopy(*fdFrom);                 // by copying from `from` to `to`
     di = *fd;                                   // convert to XP's draw info
+    if (!bFrom)                                 // when will we need the next data?
+        gDueQueue.emplace(fd->ts, GetModeS_ID());
     di.y += GetVertOfs();                       // vertical offset to make plane move on wheels
+    bLight = FlightDataCatLight(fd->category);  // category policy can make it a lightweight object
     
     // Test for a change in model-defining data, need a new CSL model match?
-    if (!bFrom &&
-        (fd->icaoType       != acIcaoType       ||
-         fd->icaoAirline    != acIcaoAirline    ||
-         fd->tailNum        != acLivery))
+    // (The actual change is deferred to ApplyModelChange(), which runs outside the data lock)
+    if (!bFrom && !IsSameModel(fd->icaoType, fd->icaoAirline, fd->tailNum))
     {
-        ChangeModel(fd->icaoType, fd->icaoAirline, fd->tailNum);
+        mdlIcaoType     = fd->icaoType;
+        mdlIcaoAirline  = fd->icaoAirline;
+        mdlLivery       = fd->tailNum;
+        bMdlChangePending = true;
+        gMdlChangeIds.insert(GetModeS_ID());
     }
     
-    // Calculate the aircraft label
-    if (!fd->label.empty()) {                   // label is passed in
-        label = fd->label;
-    }
-    else
-    {
-        if (fd->callSign.empty()) {             // Id is callsign or hex id
-            char sId[10];
-            snprintf(sId, sizeof(sId), "0x%06X", modeS_id);
-            label = sId;
-        } else
-            label = fd->callSign;
-
-        if (!fd->icaoType.empty()) {            // Add a/c type
-            label += " (";
-            label += fd->icaoType;
-            label += ')';
-        }
+    // Calculate the aircraft label, but only if its defining fields changed
+    if (fd->labelKey == labelKey)
+        ++gNumLabelReused;
+    else {
+        ++gNumLabelRebuilds;
+        labelKey = fd->labelKey;
+        fd->BuildLabel(label);
     }
 }
 
-
-
-// Clamp to ground: Make sure the plane is not below ground, corrects Aircraft::drawInfo if needed.
+// Determine ground altitude of a given location, provisionally if terrain probes are pending
 void Plane::DetermineGndAlt (ptrFlightDataTy& fd)
 {
-    // Make sure we have a probe object (an attribute of XPMP2::Aircraft and cleaned up by its destructor)
-    if (!hProbe)
-        hProbe = XPLMCreateProbe(xplm_ProbeY);
-    LOG_ASSERT(hProbe);
-    
-    // Convert lat/lon to OpenGL
-    double X = 0.0, Y = 0.0, Z = 0.0;
-    XPLMWorldToLocal(fd->lat, fd->lon, 0.0,
-                     &X, &Y, &Z);
-    
-    // Where's the ground?
-    XPLMProbeInfo_t infoProbe = {
-        sizeof(XPLMProbeInfo_t),            // structSIze
-        0.0f, 0.0f, 0.0f,                   // location
-        0.0f, 0.0f, 0.0f,                   // normal vector
-        0.0f, 0.0f, 0.0f,                   // velocity vector
-        0                                   // is_wet
-    };
-    if (XPLMProbeTerrainXYZ(hProbe,
-                            float(X), float(Y), float(Z),
-                            &infoProbe) == xplm_ProbeHitTerrain)
-    {
-        // Return the altitude back to world coordinates
-        XPLMLocalToWorld(double(infoProbe.locationX),
-                         double(infoProbe.locationY),
-                         double(infoProbe.locationZ),
-                         &X, &Y, &fd->alt_m);
-    }
-    else {
-        // probe failed...so we need to assume something
-        fd->alt_m = 0.0;
+    fd->bGndAltPending = !TerrainTryGetAlt(fd->lat, fd->lon, fd->alt_m);
+    if (!fd->bGndAltPending)
+        return;
+    gGndAltIds.insert(GetModeS_ID());
+    
+    // Until probes are available we need a provisional altitude:
+    // The altitude we are at, else nearby known terrain, else the reported altitude, else the terrain below the camera
+    if (&fd != &fdFrom && !std::isnan(fdFrom->alt_m))
+        fd->alt_m = fdFrom->alt_m;
+    else if (!TerrainGuessAlt(fd->lat, fd->lon, fd->alt_m) && std::isnan(fd->alt_m))
+        fd->alt_m = double(TerrainCameraGndAlt());
+}
+
+// Correct provisional ground altitudes once terrain probes are available
+bool Plane::ResolveGndAlt ()
+{
+    bool bChanged = false;
+    for (bool bFrom: { true, false }) {
+        ptrFlightDataTy& fd = bFrom ? fdFrom : fdTo;
+        XPLMDrawInfo_t&  di = bFrom ? diFrom : diTo;
+        if (!fd->bGndAltPending ||
+            !TerrainTryGetAlt(fd->lat, fd->lon, fd->alt_m, true))
+            continue;
+        
+        // Only the location is corrected, attitude stays as is
+        fd->bGndAltPending = false;
+        double x = 0.0, y = 0.0, z = 0.0;
+        ProjWorldToLocal(fd->lat, fd->lon, fd->alt_m, x, y, z);
+        di.x = float(x);
+        di.y = float(y) + GetVertOfs();
+        di.z = float(z);
+        bChanged = true;
     }
+    if (bChanged)
+        KinUpdate();
+    return fdFrom->bGndAltPending || fdTo->bGndAltPending;
 }
+
 // Should this plane be removed?
 bool Plane::ShallBeRemoved (const tsTy& cutOff) const
 {
@@ -286,12 +904,112 @@ bool Plane::ShallBeRemoved (const tsTy& cutOff) const
 // This data is updated once per cycle, then reused by other Update... calls
 int Plane::flCounter = -1;          ///< flight loop counter of last update
 tsTy::rep Plane::ticksNow = 0;      ///< 'now' timestamp
+Plane::LodStatsTy Plane::lodCurr;   ///< level-of-detail statistics of the current frame
+Plane::LodStatsTy Plane::lodLast;   ///< level-of-detail statistics of the last completed frame
+float Plane::lodCostUs = 0.0f;      ///< average cost of one detail update [us]
 
 // Once per cycle activities
 void Plane::OncePerCycle (int _flCounter)
 {
     if (_flCounter <= flCounter) return;
-    ticksNow = std::chrono::system_clock::now().time_since_epoch().count();
+    
+    // Level-of-detail statistics: finish the previous frame
+    if (lodCurr.bMeasured && lodCurr.nUpdated > 0) {
+        const float cost = lodCurr.measuredUs / float(lodCurr.nUpdated);
+        lodCostUs = lodCostUs > 0.0f ? std::fmaf(LOD_COST_SMOOTHING, cost - lodCostUs, lodCostUs) : cost;
+    }
+    lodLast = lodCurr;
+    lodCurr = LodStatsTy();
+    lodCurr.bMeasured = (_flCounter % LOD_MEASURE_INTERVAL) == 0;
+    
+    flCounter = _flCounter;
+    
+    // Has X-Plane shifted its local coordinate system?
+    if (ProjUpdateRef())
+        RebaseAll();
+    
+    const tsTy now = std::chrono::system_clock::now();
+    if (ticksNow)                                       // tell the network thread the render rate
+        glob.framePeriod = std::chrono::duration<float>(now - tsTy(tsTy::duration(ticksNow))).count();
+    ticksNow = now.time_since_epoch().count();
+    
+    // Compute all planes' interpolated values in one go
+    glob.kin.Compute(KinTime(now));
+}
+
+// Recompute all planes' local coordinates after a change of the reference point
+void Plane::RebaseAll ()
+{
+    // Lightweight records and planes waiting for creation are only known to the spatial index,
+    // they are rebased from their youngest data
+    std::vector<XPMPPlaneID> vecIds;
+    glob.spatial.GetIds(vecIds);
+    std::vector<std::pair<XPMPPlaneID,ptrFlightDataTy>> vecRecs;
+    {
+        std::lock_guard<std::mutex> guard(glob.mtxListFD);
+        std::unordered_map<XPMPPlaneID,const PlaneCreateReqTy*> mapQueued;
+        for (const PlaneCreateReqTy& req: gCreateQueue)
+            mapQueued.emplace(req.id, &req);
+        for (const XPMPPlaneID id: vecIds) {
+            if (glob.mapPlanes.count(id))
+                continue;
+            auto iPlaneFD = glob.mapListFD.find(id);
+            auto iQueued = mapQueued.find(id);
+            if (iPlaneFD != glob.mapListFD.end() && !iPlaneFD->second.empty())
+                vecRecs.emplace_back(id, iPlaneFD->second.back());
+            else if (iQueued != mapQueued.end())
+                vecRecs.emplace_back(id, iQueued->second->to);
+            else
+                // no data left to rebase from, it returns with its next data
+                glob.spatial.Remove(id);
+        }
+    }
+    
+    const size_t n = 2 * glob.mapPlanes.size() + vecRecs.size();
+    if (!n) return;
+    
+    // Collect all from/to positions and records...
+    std::vector<double> lat, lon, alt;
+    lat.reserve(n); lon.reserve(n); alt.reserve(n);
+    for (const auto& p: glob.mapPlanes) {
+        for (const FlightData* fd: { p.second.fdFrom.get(), p.second.fdTo.get() }) {
+            lat.push_back(fd->lat);
+            lon.push_back(fd->lon);
+            alt.push_back(NZ(fd->alt_m));
+        }
+    }
+    for (const auto& rec: vecRecs) {
+        lat.push_back(rec.second->lat);
+        lon.push_back(rec.second->lon);
+        alt.push_back(NZ(rec.second->alt_m));
+    }
+    
+    // ...convert them in one batch...
+    std::vector<double> x(n), y(n), z(n);
+    ProjWorldToLocal(n, lat.data(), lon.data(), alt.data(),
+                     x.data(), y.data(), z.data());
+    
+    // ...and distribute the results back
+    size_t i = 0;
+    for (auto& p: glob.mapPlanes) {
+        Plane& plane = p.second;
+        const float vertOfs = plane.GetVertOfs();
+        for (XPLMDrawInfo_t* di: { &plane.diFrom, &plane.diTo }) {
+            di->x = float(x[i]);
+            di->y = float(y[i]) + vertOfs;
+            di->z = float(z[i]);
+            ++i;
+        }
+        plane.KinUpdate();
+        // preliminary position in the spatial index until the next UpdatePosition()
+        glob.spatial.Update(p.first, plane.diTo.x, plane.diTo.z);
+    }
+    for (const auto& rec: vecRecs) {
+        glob.spatial.Update(rec.first, float(x[i]), float(z[i]));
+        ++i;
+    }
+    LOG_MSG(logDEBUG, "Rebased %lu planes and %lu lightweight records to the new reference point",
+            (unsigned long)glob.mapPlanes.size(), (unsigned long)vecRecs.size());
 }
 
 //
@@ -301,24 +1019,32 @@ void Plane::OncePerCycle (int _flCounter)
 // Constructor from two flight data objects
 Plane::Plane (ptrFlightDataTy&& from, ptrFlightDataTy&& to) :
 XPMP2::Aircraft(from->icaoType, from->icaoAirline, from->tailNum,
-                from->_modeS_id)
+                from->_modeS_id,
+                MdlMatchLookup(from->icaoType, from->icaoAirline, from->tailNum)),
+mdlIcaoType(from->icaoType), mdlIcaoAirline(from->icaoAirline), mdlLivery(from->tailNum)
 {
+    // Remember the model matching result for later planes of the same kind
+    MdlMatchStore(mdlIcaoType, mdlIcaoAirline, mdlLivery, GetModelName());
+    
     // Take over the flight data
     TakeOverData(true,  std::move(from));
     TakeOverData(false, std::move(to));
+    
+    // Register with the kinematics engine
+    kinIdx = glob.kin.Add();
+    CalcPathVel(nullptr, nullptr);
+    KinUpdate();
 }
 
 // Destructor
 Plane::~Plane ()
-{}
-
-/// @brief Calculate interpolation between 0 and 1 from the FlightData objects
-/// @details If `to` is `NAN` then does nothing, does not change the existing value,
-///          else if `from` is `NAN` sets just the `to` value,
-///          otherwise interpolates between `from` and `to` using `f`
-#define IP_01(fct,v)                                                            \
-fct(std::clamp<float>(std::fmaf(f, fdTo->v - fdFrom->v, fdFrom->v), 0.0f,1.0f));
-// fmaf(x,y,z) = x*y + z
+{
+    // parked planes have already left kinematics and spatial index, and their id might be in use again
+    if (kinIdx >= 0) {
+        glob.kin.Remove(kinIdx);
+        glob.spatial.Remove(modeS_id);
+    }
+}
 
 // Called by XPMP2 right before updating the aircraft's placement in the world
 void Plane::UpdatePosition (float _elapsedSinceLastCall, int _flCounter)
@@ -327,51 +1053,81 @@ void Plane::UpdatePosition (float _elapsedSinceLastCall, int _flCounter)
         // Once per cycle
         OncePerCycle(_flCounter);
         
-        // Interpolation between fdFrom and fdTo
-        const tsTy::rep tsFrom = fdFrom->ts.time_since_epoch().count();
-        const tsTy::rep tsTo   = fdTo->ts.time_since_epoch().count();
+        // Parked planes don't move
+        if (kinIdx < 0)
+            return;
+        
+        // Sleeping planes keep their frozen draw info until new data wakes them up
+        if (bSleeping) {
+            ++lodCurr.nSleeping;
+            return;
+        }
+        
+        // All interpolation has already been done in bulk by the kinematics engine,
+        // we just copy out the results
+        const KinEngine& kin = glob.kin;
         // _the_ factor: increases from 0 to 1 while `now` is between `from` and `to` (->interpolation),
         // and becomes larger than 1 if `now` increases even beyond `to` (-> extrapolation)
-        f = float(ticksNow - tsFrom) / float(tsTo - tsFrom);
+        f = kin.GetF(kinIdx);
         LOG_ASSERT(!std::isnan(f));
         
-        // Update the drawInfo with interpolated values
-        // Location [ fmaf(x,y,z) = x*y + z ]
-        drawInfo.x      = std::fmaf(f, diTo.x - diFrom.x, diFrom.x);
-        drawInfo.y      = std::fmaf(f, diTo.y - diFrom.y, diFrom.y);
-        drawInfo.z      = std::fmaf(f, diTo.z - diFrom.z, diFrom.z);
+        // Location
+        drawInfo.x      = kin.Get(kinIdx, KC_X);
+        drawInfo.y      = kin.Get(kinIdx, KC_Y);
+        drawInfo.z      = kin.Get(kinIdx, KC_Z);
+        glob.spatial.Update(modeS_id, drawInfo.x, drawInfo.z);
         
         // if we are extrapolating on the ground we run into danger of running into ground,
         // so have XPMP2 clamp us to the ground while extrapolating (only)
         bClampToGround = (fdFrom->bGnd || fdTo->bGnd) && f > 1.0f;
         
-        // for all the following values we cap `f` at 1.25 so we don't do too much of spinning etc in case we are missing future updates
+        // for all the following values `f` is capped at 1.25 so we don't do too much of spinning etc in case we are missing future updates
         if (f > MAX_F) f = MAX_F;
         
         // Attitude
-        drawInfo.pitch  = std::fmaf(f, diTo.pitch - diFrom.pitch,              diFrom.pitch);
-        drawInfo.roll   = std::fmaf(f, diTo.roll  - diFrom.roll,               diFrom.roll);
-        drawInfo.heading= std::fmaf(f, HeadDiff(diFrom.heading, diTo.heading), diFrom.heading);
+        drawInfo.pitch  = kin.Get(kinIdx, KC_PITCH);
+        drawInfo.roll   = kin.Get(kinIdx, KC_ROLL);
+        drawInfo.heading= kin.Get(kinIdx, KC_HEADING);
+        
+        // Visibility
+        if (f <= 0.5f) {
+            if (fdFrom->bVisDefined)
+                SetVisible(fdFrom->bVisible);
+        } else {
+            if (fdTo->bVisDefined)
+                SetVisible(fdTo->bVisible);
+        }
+        
+        // Level of detail: Far away planes update configuration, lights, and animation only every n-th frame,
+        // staggered by id so that not all planes of a band update in the same frame
+        elapsedSinceDetail += _elapsedSinceLastCall;
+        const int lodIntvl = bLight ? LOD_INTVL_LIGHT : LodInterval(GetCameraDist());
+        if (lodIntvl > 1 && (unsigned(flCounter) + modeS_id) % unsigned(lodIntvl) != 0) {
+            ++lodCurr.nSkipped;
+            return;
+        }
+        ++lodCurr.nUpdated;
+        const auto tStart = lodCurr.bMeasured ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        const float elapsed = elapsedSinceDetail;
+        elapsedSinceDetail = 0.0f;
         
         // Configuration
-        IP_01(SetGearRatio, gear);
-        SetNoseWheelAngle(std::fmaf(f, HeadDiff(fdFrom->nws, fdTo->nws), fdFrom->nws));
-        IP_01(SetFlapRatio, flaps);                 // flaps and slats the same
+        SetGearRatio(kin.Get(kinIdx, KC_GEAR));
+        SetNoseWheelAngle(kin.Get(kinIdx, KC_NWS));
+        SetFlapRatio(kin.Get(kinIdx, KC_FLAPS));            // flaps and slats the same
         SetSlatRatio(GetFlapRatio());
-        IP_01(SetSpoilerRatio, spoilers);           // spoilers and speed brakes the same
+        SetSpoilerRatio(kin.Get(kinIdx, KC_SPOILERS));      // spoilers and speed brakes the same
         SetSpeedbrakeRatio(GetSpoilerRatio());
-        IP_01(SetReversDeployRatio, reversers);     // reversers
-
-        // thrust ration (goes from -1 to 1)
-        SetThrustRatio(std::clamp<float>(std::fmaf(f, fdTo->thrust - fdFrom->thrust, fdFrom->thrust), -1.0f, 1.0f));
+        SetReversDeployRatio(kin.Get(kinIdx, KC_REVERSERS));
+        SetThrustRatio(kin.Get(kinIdx, KC_THRUST));         // thrust ration (goes from -1 to 1)
         
         // we keep engine and rotor RPM the same for simplicity
-        SetEngineRotRpm(std::fmaf(f, fdTo->engineRpm - fdFrom->engineRpm, fdFrom->engineRpm));
+        SetEngineRotRpm(kin.Get(kinIdx, KC_RPM));
         SetPropRotRpm(GetEngineRotRpm());
 
         // Rotor/Engine angle is _computed_ here:
         // Make props and rotors move based on rotation speed and time passed since last cycle
-        SetEngineRotAngle(RpmToAngle(GetEngineRotAngle(), GetEngineRotRpm(), _elapsedSinceLastCall));
+        SetEngineRotAngle(RpmToAngle(GetEngineRotAngle(), GetEngineRotRpm(), elapsed));
         SetPropRotAngle(GetEngineRotAngle());
 
         // 'Moment' of touch down is computed here, too
@@ -383,22 +1139,13 @@ void Plane::UpdatePosition (float _elapsedSinceLastCall, int _flCounter)
             }
         } else {
             // we are in a "touching down" phase, keep track of time passed
-            tTouchDown += _elapsedSinceLastCall;
+            tTouchDown += elapsed;
             if (tTouchDown >= TOUCH_DOWN_TIME) {
                 SetTouchDown(false);
                 tTouchDown = NAN;
             }
         }
 
-        // Visibility
-        if (f <= 0.5f) {
-            if (fdFrom->bVisDefined)
-                SetVisible(fdFrom->bVisible);
-        } else {
-            if (fdTo->bVisDefined)
-                SetVisible(fdTo->bVisible);
-        }
-        
         // Lights
         const FlightData::lightsTy& lights = (f >= 0.5) ? fdTo->lights : fdFrom->lights;
         if (lights.defined) {
@@ -408,6 +1155,14 @@ void Plane::UpdatePosition (float _elapsedSinceLastCall, int _flCounter)
             SetLightsStrobe(lights.strobe);
             SetLightsNav(lights.nav);
         }
+        
+        // A stationary plane, which has completed all its transitions, can go to sleep
+        if (bStationary && std::isnan(tTouchDown))
+            bSleeping = true;
+        
+        // Sample the cost of a detail update
+        if (lodCurr.bMeasured)
+            lodCurr.measuredUs += std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - tStart).count();
     }
     catch (const std::exception& e) {
         LOG_MSG(logWARN, "Updating 0x%06X failed: %s", modeS_id, e.what());
@@ -429,14 +1184,63 @@ float Plane::GetLift() const
 }
 
 
+// Update interval in frames for a given camera distance
+int Plane::LodInterval (float dist)
+{
+    if (glob.lodDist8 > 0 && dist >= float(glob.lodDist8)) return 8;
+    if (glob.lodDist4 > 0 && dist >= float(glob.lodDist4)) return 4;
+    if (glob.lodDist2 > 0 && dist >= float(glob.lodDist2)) return 2;
+    return 1;
+}
+
 //
 // MARK: Global Functions
 //
 
+// Number of planes reused from the recycle pool
+int PlaneNumRecycled ()
+{ return gNumRecycled; }
+
+// Number of label rebuilds due to changed label-defining fields
+int PlaneLabelRebuilds ()
+{ return gNumLabelRebuilds; }
+
+// Number of updates, which reused the existing label
+int PlaneLabelReused ()
+{ return gNumLabelReused; }
+
+// Number of planes currently parked in the recycle pool
+int PlaneNumParked ()
+{ return int(gPool.size()); }
+
+// Average time from receiving an aircraft's first data to displaying it [s]
+float PlaneTimeToDisplay ()
+{ return gTimeToDisplay; }
+
+// Number of detail updates performed in the last frame
+int PlaneLodUpdated ()
+{ return Plane::GetLodStats().nUpdated; }
+
+// Number of detail updates skipped in the last frame due to level of detail
+int PlaneLodSkipped ()
+{ return Plane::GetLodStats().nSkipped; }
+
+// Estimated time saved in the last frame due to level of detail [us]
+float PlaneLodSavedUs ()
+{ return float(Plane::GetLodStats().nSkipped) * Plane::GetLodCostUs(); }
+
+// Number of stationary planes, which were asleep in the last frame
+int PlaneNumSleeping ()
+{ return Plane::GetLodStats().nSleeping; }
+
+// Did the last plane maintenance exceed its budget?
+bool PlaneMaintOverloaded ()
+{ return gMaintOverloaded; }
+
 /// Initialie the Plane module
 bool PlaneStartup()
 {
-    // doesn't do anything at the moment
+    MdlLiveriesCollect();
     return true;
 }
 
@@ -444,5 +1248,17 @@ bool PlaneStartup()
 void PlaneShutdown()
 {
     // remove all planes
+    gCreateQueue.clear();
+    gCreateIds.clear();
+    gPool.clear();
+    gTierPromote.clear();
+    gTierKeep.clear();
     glob.mapPlanes.clear();
+    glob.kin.Clear();
+    glob.spatial.Clear();
+    glob.expiry.Clear();
+    gMdlMatchCache.clear();
+    gMdlMatchList.clear();
+    gMdlLiveries.clear();
+    PlanePendingClear();
 }
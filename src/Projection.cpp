@@ -0,0 +1,342 @@
+/// @file       Projection.cpp
+/// @brief      Thread-safe conversion between geodetic and X-Plane's local OpenGL coordinates
+/// @details    Reproduces X-Plane's local coordinate frame from the reference point dataRefs
+///             (`sim/flightmodel/position/lat_ref`/`lon_ref`), so that conversions
+///             don't require XPLM calls and can be done from any thread and in batches.
+///             The local frame is a Cartesian frame with its origin on sea level at the
+///             reference point, +X pointing east, +Y up, and +Z south.
+///             When the reference point changes (X-Plane shifting its origin)
+///             all cached local coordinates are rebased in one pass.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: SIMD abstraction
+//
+
+// Vector operations on doubles, mapped to what the target platform offers
+// (see Kinematics.cpp for the float equivalent)
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+typedef __m128d vdTy;                                   ///< vector of doubles
+constexpr size_t PROJ_W = 2;                            ///< vector width
+#define VD_LOAD(p)      _mm_loadu_pd(p)
+#define VD_STORE(p,v)   _mm_storeu_pd(p,v)
+#define VD_SET1(x)      _mm_set1_pd(x)
+#define VD_ADD(a,b)     _mm_add_pd(a,b)
+#define VD_MUL(a,b)     _mm_mul_pd(a,b)
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+typedef float64x2_t vdTy;                               ///< vector of doubles
+constexpr size_t PROJ_W = 2;                            ///< vector width
+#define VD_LOAD(p)      vld1q_f64(p)
+#define VD_STORE(p,v)   vst1q_f64(p,v)
+#define VD_SET1(x)      vdupq_n_f64(x)
+#define VD_ADD(a,b)     vaddq_f64(a,b)
+#define VD_MUL(a,b)     vmulq_f64(a,b)
+#else
+typedef double vdTy;                                    ///< no SIMD available, plain scalar
+constexpr size_t PROJ_W = 1;                            ///< vector width
+#define VD_LOAD(p)      (*(p))
+#define VD_STORE(p,v)   (*(p) = (v))
+#define VD_SET1(x)      (x)
+#define VD_ADD(a,b)     ((a)+(b))
+#define VD_MUL(a,b)     ((a)*(b))
+#endif
+
+/// Dot product of the vectors `(dx,dy,dz)` with the constant vector `(v0,v1,v2)`
+#define VD_DOT(dx,dy,dz,v0,v1,v2) VD_ADD(VD_ADD(VD_MUL(dx,v0), VD_MUL(dy,v1)), VD_MUL(dz,v2))
+
+/// Number of points batch conversions process per chunk, sized to keep the intermediate arrays on the stack
+constexpr size_t PROJ_CHUNK = 64;
+
+//
+// MARK: Earth models
+//
+
+/// Earth radius if X-Plane models the earth as a sphere [m]
+constexpr double XP_EARTH_RADIUS_M  = 6378145.0;
+/// WGS84 semi-major axis [m]
+constexpr double WGS84_A            = 6378137.0;
+/// WGS84 squared eccentricity
+constexpr double WGS84_E2           = 6.69437999014e-3;
+
+/// Offset of the calibration test point from the reference point [deg]
+constexpr double PROJ_CALIB_OFS     = 0.5;
+/// Altitude of the calibration test point [m]
+constexpr double PROJ_CALIB_ALT     = 1000.0;
+/// Maximum deviation from `XPLMWorldToLocal` at the calibration test point we accept [m]
+constexpr double PROJ_MAX_DEV_M     = 0.5;
+
+/// Earth model candidates, tested against X-Plane whenever the reference point changes
+static const struct { const char* name; double a; double e2; } PROJ_MODELS[] = {
+    { "sphere", XP_EARTH_RADIUS_M,  0.0         },
+    { "WGS84",  WGS84_A,            WGS84_E2    },
+};
+
+//
+// MARK: ProjParamsTy
+//
+
+// Set up for a reference point and an earth model
+void ProjParamsTy::Init (double _lat_ref, double _lon_ref, double _a, double _e2)
+{
+    lat_ref = _lat_ref;
+    lon_ref = _lon_ref;
+    a       = _a;
+    e2      = _e2;
+
+    // Origin is on the ellipsoid's surface below the reference point
+    GeoToEcef(lat_ref, lon_ref, 0.0, o);
+    
+    // Local east/north/up unit vectors at the origin
+    const double sLat = std::sin(deg2rad(lat_ref)), cLat = std::cos(deg2rad(lat_ref));
+    const double sLon = std::sin(deg2rad(lon_ref)), cLon = std::cos(deg2rad(lon_ref));
+    east[0]  = -sLon;           east[1]  =  cLon;           east[2]  = 0.0;
+    north[0] = -sLat * cLon;    north[1] = -sLat * sLon;    north[2] = cLat;
+    up[0]    =  cLat * cLon;    up[1]    =  cLat * sLon;    up[2]    = sLat;
+}
+
+// Geodetic to ECEF coordinates
+void ProjParamsTy::GeoToEcef (double lat, double lon, double alt_m, double ecef[3]) const
+{
+    const double sLat = std::sin(deg2rad(lat)), cLat = std::cos(deg2rad(lat));
+    const double sLon = std::sin(deg2rad(lon)), cLon = std::cos(deg2rad(lon));
+    const double N = a / std::sqrt(1.0 - e2 * sLat * sLat);    // prime vertical radius of curvature
+    ecef[0] = (N + alt_m) * cLat * cLon;
+    ecef[1] = (N + alt_m) * cLat * sLon;
+    ecef[2] = (N * (1.0 - e2) + alt_m) * sLat;
+}
+
+// ECEF to geodetic coordinates
+void ProjParamsTy::EcefToGeo (const double ecef[3], double& lat, double& lon, double& alt_m) const
+{
+    const double p = std::sqrt(ecef[0]*ecef[0] + ecef[1]*ecef[1]);
+    lon = std::atan2(ecef[1], ecef[0]);
+    // Iterate latitude and altitude, converges after a few steps (immediately for a sphere)
+    double phi = std::atan2(ecef[2], p * (1.0 - e2));
+    double N = a;
+    alt_m = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        const double sPhi = std::sin(phi);
+        N = a / std::sqrt(1.0 - e2 * sPhi * sPhi);
+        alt_m = std::abs(std::cos(phi)) > 1e-9 ? p / std::cos(phi) - N :
+                                                 std::abs(ecef[2]) - N * (1.0 - e2);
+        phi = std::atan2(ecef[2], p * (1.0 - e2 * N / (N + alt_m)));
+    }
+    lat = rad2deg(phi);
+    lon = rad2deg(lon);
+}
+
+// Convert world coordinates to local coordinates
+void ProjParamsTy::WorldToLocal (double lat, double lon, double alt_m,
+                                 double& x, double& y, double& z) const
+{
+    double p[3];
+    GeoToEcef(lat, lon, alt_m, p);
+    const double d[3] = { p[0]-o[0], p[1]-o[1], p[2]-o[2] };
+    x =   d[0]*east[0]  + d[1]*east[1]  + d[2]*east[2];
+    y =   d[0]*up[0]    + d[1]*up[1]    + d[2]*up[2];
+    z = -(d[0]*north[0] + d[1]*north[1] + d[2]*north[2]);
+}
+
+// Batch-convert world coordinates to local coordinates
+void ProjParamsTy::WorldToLocal (size_t n,
+                                 const double* lat, const double* lon, const double* alt_m,
+                                 double* x, double* y, double* z) const
+{
+    // Local frame's unit vectors, with `north` negated as local z points south
+    const vdTy e0 = VD_SET1(east[0]),   e1 = VD_SET1(east[1]),   e2v = VD_SET1(east[2]);
+    const vdTy u0 = VD_SET1(up[0]),     u1 = VD_SET1(up[1]),     u2  = VD_SET1(up[2]);
+    const vdTy s0 = VD_SET1(-north[0]), s1 = VD_SET1(-north[1]), s2  = VD_SET1(-north[2]);
+    
+    double dx[PROJ_CHUNK], dy[PROJ_CHUNK], dz[PROJ_CHUNK];
+    for (size_t b = 0; b < n; b += PROJ_CHUNK) {
+        const size_t m = std::min(PROJ_CHUNK, n - b);
+        
+        // ECEF position relative to the origin, trigonometry is per point
+        for (size_t i = 0; i < m; ++i) {
+            double p[3];
+            GeoToEcef(lat[b+i], lon[b+i], alt_m[b+i], p);
+            dx[i] = p[0] - o[0];
+            dy[i] = p[1] - o[1];
+            dz[i] = p[2] - o[2];
+        }
+        
+        // Rotation into the local frame, vectorized
+        size_t i = 0;
+        for (; i + PROJ_W <= m; i += PROJ_W) {
+            const vdTy vx = VD_LOAD(dx+i), vy = VD_LOAD(dy+i), vz = VD_LOAD(dz+i);
+            VD_STORE(x+b+i, VD_DOT(vx, vy, vz, e0, e1, e2v));
+            VD_STORE(y+b+i, VD_DOT(vx, vy, vz, u0, u1, u2));
+            VD_STORE(z+b+i, VD_DOT(vx, vy, vz, s0, s1, s2));
+        }
+        for (; i < m; ++i) {                    // remainder
+            x[b+i] =   dx[i]*east[0]  + dy[i]*east[1]  + dz[i]*east[2];
+            y[b+i] =   dx[i]*up[0]    + dy[i]*up[1]    + dz[i]*up[2];
+            z[b+i] = -(dx[i]*north[0] + dy[i]*north[1] + dz[i]*north[2]);
+        }
+    }
+}
+
+// Convert local coordinates to world coordinates
+void ProjParamsTy::LocalToWorld (double x, double y, double z,
+                                 double& lat, double& lon, double& alt_m) const
+{
+    double p[3];
+    for (int i = 0; i < 3; ++i)
+        p[i] = o[i] + x * east[i] + y * up[i] - z * north[i];
+    EcefToGeo(p, lat, lon, alt_m);
+}
+
+//
+// MARK: Module-global data
+//
+
+/// Guards access to the projection parameters
+static std::mutex gMtxProj;
+/// Current projection parameters
+static ProjParamsTy gProj;
+/// Does our projection match X-Plane's closely enough?
+static bool gbProjCalibrated = false;
+
+/// @brief Fetch projection parameters for a conversion
+/// @return Shall XPLM calls be used instead? (only on the main thread when our projection isn't calibrated)
+static bool ProjFetch (ProjParamsTy& params)
+{
+    std::lock_guard<std::mutex> lock(gMtxProj);
+    params = gProj;
+    return glob.IsXPThread() && (!gbProjCalibrated || !gProj.IsValid());
+}
+
+//
+// MARK: Global Functions
+//
+
+// Main thread only: Reads the reference point, recalibrates if it changed
+bool ProjUpdateRef ()
+{
+    static XPLMDataRef drLatRef = XPLMFindDataRef("sim/flightmodel/position/lat_ref");
+    static XPLMDataRef drLonRef = XPLMFindDataRef("sim/flightmodel/position/lon_ref");
+    static bool bWarned = false;
+    const double lat_ref = double(XPLMGetDataf(drLatRef));
+    const double lon_ref = double(XPLMGetDataf(drLonRef));
+    
+    // Any change in the reference point?
+    {
+        std::lock_guard<std::mutex> lock(gMtxProj);
+        if (std::abs(lat_ref - gProj.lat_ref) < 1e-9 &&
+            std::abs(lon_ref - gProj.lon_ref) < 1e-9)
+            return false;
+    }
+    
+    // Test all earth models against X-Plane and take the best one
+    const double tLat = lat_ref + (lat_ref > 0.0 ? -PROJ_CALIB_OFS : PROJ_CALIB_OFS);
+    const double tLon = lon_ref + PROJ_CALIB_OFS;
+    double xpX = 0.0, xpY = 0.0, xpZ = 0.0;
+    XPLMWorldToLocal(tLat, tLon, PROJ_CALIB_ALT, &xpX, &xpY, &xpZ);
+    
+    ProjParamsTy best;
+    double bestDev = HUGE_VAL;
+    const char* bestName = "";
+    for (const auto& mdl: PROJ_MODELS) {
+        ProjParamsTy p;
+        p.Init(lat_ref, lon_ref, mdl.a, mdl.e2);
+        double x = 0.0, y = 0.0, z = 0.0;
+        p.WorldToLocal(tLat, tLon, PROJ_CALIB_ALT, x, y, z);
+        const double dev = std::sqrt((x-xpX)*(x-xpX) + (y-xpY)*(y-xpY) + (z-xpZ)*(z-xpZ));
+        if (dev < bestDev) {
+            best = p;
+            bestDev = dev;
+            bestName = mdl.name;
+        }
+    }
+    
+    // Store the new parameters
+    {
+        std::lock_guard<std::mutex> lock(gMtxProj);
+        gProj = best;
+        gbProjCalibrated = bestDev <= PROJ_MAX_DEV_M;
+    }
+    
+    if (bestDev <= PROJ_MAX_DEV_M) {
+        LOG_MSG(logDEBUG, "Reference point now %.4f / %.4f, projection uses %s model (deviation %.3fm)",
+                lat_ref, lon_ref, bestName, bestDev);
+    } else if (!bWarned) {
+        LOG_MSG(logWARN, "Projection deviates %.1fm from X-Plane's, falling back to XPLM calls on the main thread",
+                bestDev);
+        bWarned = true;
+    }
+    return true;
+}
+
+// Thread-safe copy of the current projection parameters
+ProjParamsTy ProjGetParams ()
+{
+    std::lock_guard<std::mutex> lock(gMtxProj);
+    return gProj;
+}
+
+// Convert world coordinates to local coordinates, can be called from any thread
+void ProjWorldToLocal (double lat, double lon, double alt_m,
+                       double& x, double& y, double& z)
+{
+    ProjParamsTy params;
+    if (ProjFetch(params))
+        XPLMWorldToLocal(lat, lon, alt_m, &x, &y, &z);
+    else if (params.IsValid())
+        params.WorldToLocal(lat, lon, alt_m, x, y, z);
+    else
+        x = y = z = NAN;
+}
+
+// Convert local coordinates to world coordinates, can be called from any thread
+void ProjLocalToWorld (double x, double y, double z,
+                       double& lat, double& lon, double& alt_m)
+{
+    ProjParamsTy params;
+    if (ProjFetch(params))
+        XPLMLocalToWorld(x, y, z, &lat, &lon, &alt_m);
+    else if (params.IsValid())
+        params.LocalToWorld(x, y, z, lat, lon, alt_m);
+    else
+        lat = lon = alt_m = NAN;
+}
+
+// Batch-convert world coordinates to local coordinates, can be called from any thread
+void ProjWorldToLocal (size_t n,
+                       const double* lat, const double* lon, const double* alt_m,
+                       double* x, double* y, double* z)
+{
+    ProjParamsTy params;
+    if (ProjFetch(params)) {
+        for (size_t i = 0; i < n; ++i)
+            XPLMWorldToLocal(lat[i], lon[i], alt_m[i], x+i, y+i, z+i);
+    }
+    else if (params.IsValid()) {
+        // Parameters are fetched only once for the whole batch
+        params.WorldToLocal(n, lat, lon, alt_m, x, y, z);
+    }
+    else {
+        std::fill_n(x, n, NAN);
+        std::fill_n(y, n, NAN);
+        std::fill_n(z, n, NAN);
+    }
+}
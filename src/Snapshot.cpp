@@ -0,0 +1,423 @@
+/// @file       Snapshot.cpp
+/// @brief      Warm restart: Persists the latest traffic state and restores it upon enabling
+/// @details    The latest two positions per aircraft are written to a compact binary
+///             file when the plugin is disabled, and in regular intervals.
+///             Upon enabling, data not yet older than the grace period is restored
+///             straight into the flight data map, so that planes reappear immediately
+///             instead of waiting for two fresh records plus the buffering period.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: File format
+//
+
+/// Path to the snapshot file, relative to X-Plane
+static const char* SNAP_FILE_NAME = "Output/preferences/" XPPLANES "_snapshot.bin";
+/// Temporary file written first, then renamed, so that an interrupted save doesn't destroy the previous snapshot
+static const char* SNAP_FILE_TMP  = "Output/preferences/" XPPLANES "_snapshot.tmp";
+/// Buffer size for error texts
+constexpr size_t SERR_LEN = 1024;
+/// File identification
+static const char SNAP_MAGIC[8] = "XPPSNAP";
+/// File format version
+constexpr uint32_t SNAP_VERSION = 3;
+
+/// File header
+struct SnapHeaderTy {
+    char        magic[8];           ///< always SNAP_MAGIC
+    uint32_t    version = 0;        ///< always SNAP_VERSION
+    uint32_t    recSize = 0;        ///< `sizeof(SnapRecTy)`, protects against layout differences between builds
+    uint32_t    count   = 0;        ///< number of records following
+};
+
+/// Fixed-size part of one record, followed by the strings, each as length and characters
+struct SnapRecTy {
+    int64_t     tsMs        = 0;    ///< timestamp [ms since epoch]
+    double      lat         = NAN;  ///< latitude
+    double      lon         = NAN;  ///< longitude
+    double      alt_m       = NAN;  ///< altitude [m]
+    uint32_t    id          = 0;    ///< plane id
+    float       pitch       = NAN;  ///< pitch
+    float       heading     = NAN;  ///< heading
+    float       roll        = NAN;  ///< roll
+    float       track       = NAN;  ///< track
+    float       gs_m        = NAN;  ///< ground speed [m/s]
+    float       vs_m        = NAN;  ///< vertical speed [m/s]
+    float       trackRate   = NAN;  ///< track rate [deg/s]
+    float       wingSpan_m  = NAN;  ///< wake: wing span
+    float       wingArea_m2 = NAN;  ///< wake: wing area
+    float       mass_kg     = NAN;  ///< wake: mass
+    float       lift        = NAN;  ///< wake: lift
+    float       gear        = NAN;  ///< gear ratio
+    float       nws         = NAN;  ///< nose wheel steering
+    float       flaps       = NAN;  ///< flap ratio
+    float       spoilers    = NAN;  ///< spoiler ratio
+    float       reversers   = NAN;  ///< reversers ratio
+    float       thrust      = NAN;  ///< thrust ratio
+    float       engineRpm   = NAN;  ///< engine rpm
+    uint32_t    flags       = 0;    ///< bits, see SNAP_F_...
+};
+
+// Bits in SnapRecTy::flags
+constexpr uint32_t SNAP_F_GND       = 0x0001;   ///< on the ground
+constexpr uint32_t SNAP_F_VIS_DEF   = 0x0002;   ///< visibility defined
+constexpr uint32_t SNAP_F_VISIBLE   = 0x0004;   ///< visible
+constexpr uint32_t SNAP_F_LIGHTS    = 0x0010;   ///< lights defined
+constexpr uint32_t SNAP_F_TAXI      = 0x0020;   ///< taxi lights
+constexpr uint32_t SNAP_F_LANDING   = 0x0040;   ///< landing lights
+constexpr uint32_t SNAP_F_BEACON    = 0x0080;   ///< beacon lights
+constexpr uint32_t SNAP_F_STROBE    = 0x0100;   ///< strobe lights
+constexpr uint32_t SNAP_F_NAV       = 0x0200;   ///< navigation lights
+constexpr int      SNAP_F_CAT_SHIFT = 16;       ///< bits 16..23 hold the emitter category code
+
+/// Write a string as length and characters
+static void SnapPutStr (std::ostream& out, const std::string& s)
+{
+    const uint16_t len = uint16_t(std::min<size_t>(s.size(), UINT16_MAX));
+    out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.write(s.data(), len);
+}
+
+/// Read a string as length and characters
+static bool SnapGetStr (std::istream& in, std::string& s)
+{
+    uint16_t len = 0;
+    if (!in.read(reinterpret_cast<char*>(&len), sizeof(len)))
+        return false;
+    s.resize(len);
+    return len == 0 || bool(in.read(&s[0], len));
+}
+
+/// Write one flight data record
+static void SnapPutRec (std::ostream& out, const FlightData& fd)
+{
+    SnapRecTy rec;
+    rec.tsMs        = std::chrono::duration_cast<std::chrono::milliseconds>(fd.ts.time_since_epoch()).count();
+    rec.lat         = fd.lat;
+    rec.lon         = fd.lon;
+    rec.alt_m       = fd.alt_m;
+    rec.id          = fd._modeS_id;
+    rec.pitch       = fd.pitch;
+    rec.heading     = fd.heading;
+    rec.roll        = fd.roll;
+    rec.track       = fd.track;
+    rec.gs_m        = fd.gs_m;
+    rec.vs_m        = fd.vs_m;
+    rec.trackRate   = fd.trackRate;
+    rec.wingSpan_m  = fd.wake.wingSpan_m;
+    rec.wingArea_m2 = fd.wake.wingArea_m2;
+    rec.mass_kg     = fd.wake.mass_kg;
+    rec.lift        = fd.wake.lift;
+    rec.gear        = fd.gear;
+    rec.nws         = fd.nws;
+    rec.flaps       = fd.flaps;
+    rec.spoilers    = fd.spoilers;
+    rec.reversers   = fd.reversers;
+    rec.thrust      = fd.thrust;
+    rec.engineRpm   = fd.engineRpm;
+    rec.flags       = (fd.bGnd           ? SNAP_F_GND      : 0) |
+                      (fd.bVisDefined    ? SNAP_F_VIS_DEF  : 0) |
+                      (fd.bVisible       ? SNAP_F_VISIBLE  : 0) |
+                      (fd.lights.defined ? SNAP_F_LIGHTS   : 0) |
+                      (fd.lights.taxi    ? SNAP_F_TAXI     : 0) |
+                      (fd.lights.landing ? SNAP_F_LANDING  : 0) |
+                      (fd.lights.beacon  ? SNAP_F_BEACON   : 0) |
+                      (fd.lights.strobe  ? SNAP_F_STROBE   : 0) |
+                      (fd.lights.nav     ? SNAP_F_NAV      : 0) |
+                      (uint32_t(fd.category) << SNAP_F_CAT_SHIFT);
+    out.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    SnapPutStr(out, fd.icaoType);
+    SnapPutStr(out, fd.icaoAirline);
+    SnapPutStr(out, fd.tailNum);
+    SnapPutStr(out, fd.callSign);
+    SnapPutStr(out, fd.label);
+}
+
+/// Read one flight data record, returns `nullptr` if reading failed
+static ptrFlightDataTy SnapGetRec (std::istream& in)
+{
+    SnapRecTy rec;
+    if (!in.read(reinterpret_cast<char*>(&rec), sizeof(rec)))
+        return nullptr;
+    ptrFlightDataTy pFD = std::make_shared<FlightData>();
+    FlightData& fd = *pFD;
+    if (!SnapGetStr(in, fd.icaoType) ||
+        !SnapGetStr(in, fd.icaoAirline) ||
+        !SnapGetStr(in, fd.tailNum) ||
+        !SnapGetStr(in, fd.callSign) ||
+        !SnapGetStr(in, fd.label))
+        return nullptr;
+    fd.ts               = tsTy(std::chrono::duration_cast<tsTy::duration>(std::chrono::milliseconds(rec.tsMs)));
+    fd.lat              = rec.lat;
+    fd.lon              = rec.lon;
+    fd.alt_m            = rec.alt_m;
+    fd._modeS_id        = rec.id;
+    fd.pitch            = rec.pitch;
+    fd.heading          = rec.heading;
+    fd.roll             = rec.roll;
+    fd.track            = rec.track;
+    fd.gs_m             = rec.gs_m;
+    fd.vs_m             = rec.vs_m;
+    fd.trackRate        = rec.trackRate;
+    fd.wake.wingSpan_m  = rec.wingSpan_m;
+    fd.wake.wingArea_m2 = rec.wingArea_m2;
+    fd.wake.mass_kg     = rec.mass_kg;
+    fd.wake.lift        = rec.lift;
+    fd.gear             = rec.gear;
+    fd.nws              = rec.nws;
+    fd.flaps            = rec.flaps;
+    fd.spoilers         = rec.spoilers;
+    fd.reversers        = rec.reversers;
+    fd.thrust           = rec.thrust;
+    fd.engineRpm        = rec.engineRpm;
+    fd.bGnd             = rec.flags & SNAP_F_GND;
+    fd.bVisDefined      = rec.flags & SNAP_F_VIS_DEF;
+    fd.bVisible         = rec.flags & SNAP_F_VISIBLE;
+    fd.lights.defined   = rec.flags & SNAP_F_LIGHTS;
+    fd.lights.taxi      = rec.flags & SNAP_F_TAXI;
+    fd.lights.landing   = rec.flags & SNAP_F_LANDING;
+    fd.lights.beacon    = rec.flags & SNAP_F_BEACON;
+    fd.lights.strobe    = rec.flags & SNAP_F_STROBE;
+    fd.lights.nav       = rec.flags & SNAP_F_NAV;
+    const uint32_t cat  = (rec.flags >> SNAP_F_CAT_SHIFT) & 0xFF;
+    fd.category         = cat < FD_NUM_CAT ? uint8_t(cat) : 0;
+    return pFD;
+}
+
+//
+// MARK: Save and Restore
+//
+
+/// Time of last save
+static std::chrono::steady_clock::time_point gSnapLastSave;
+/// Thread writing the snapshot file
+static std::thread gSnapThr;
+/// Is the snapshot thread still writing?
+static std::atomic<bool> gbSnapWriting(false);
+
+/// Main thread: Collect the youngest two records per aircraft and serialize them into a buffer
+/// @param[out] nAc Number of aircraft collected
+/// @return Snapshot file content, empty if there is nothing to save
+static std::string SnapshotCollect (size_t& nAc)
+{
+    // The youngest two records per aircraft, `second` being the youngest
+    std::map<XPMPPlaneID, std::pair<ptrFlightDataTy,ptrFlightDataTy>> mapLatest;
+    auto Keep = [&](const ptrFlightDataTy& pFD)
+    {
+        auto& latest = mapLatest[pFD->_modeS_id];
+        if (!latest.second || latest.second->ts < pFD->ts) {
+            latest.first = std::move(latest.second);
+            latest.second = pFD;
+        }
+        else if (latest.second != pFD && (!latest.first || latest.first->ts < pFD->ts))
+            latest.first = pFD;
+    };
+
+    // Planes' current from/to positions, then any data still waiting to be processed
+    std::ostringstream out (std::ios_base::out | std::ios_base::binary);
+    {
+        std::lock_guard<std::mutex> guard(glob.mtxListFD);
+        for (const auto& p: glob.mapPlanes) {
+            if (p.second.GetFdFrom()) Keep(p.second.GetFdFrom());
+            if (p.second.GetFdTo())   Keep(p.second.GetFdTo());
+        }
+        for (const auto& p: glob.mapListFD)
+            for (const ptrFlightDataTy& pFD: p.second)
+                Keep(pFD);
+
+        // Nothing to save? Then we leave a previous snapshot alone, it ages out by itself
+        nAc = mapLatest.size();
+        if (mapLatest.empty())
+            return std::string();
+
+        // Serialize while the records can't change
+        SnapHeaderTy hdr;
+        std::memcpy(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic));
+        hdr.version = SNAP_VERSION;
+        hdr.recSize = sizeof(SnapRecTy);
+        for (const auto& p: mapLatest)
+            hdr.count += p.second.first ? 2 : 1;
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        for (const auto& p: mapLatest) {
+            if (p.second.first)
+                SnapPutRec(out, *p.second.first);
+            SnapPutRec(out, *p.second.second);
+        }
+    }
+    return out.str();
+}
+
+/// Write the collected snapshot to file, can run in a separate thread
+static bool SnapshotWrite (const std::string& buf, size_t nAc)
+{
+    // Write to a temporary file first
+    std::ofstream fOut (SNAP_FILE_TMP, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (!fOut) {
+        char sErr[SERR_LEN];
+        strerror_s(sErr, sizeof(sErr), errno);
+        LOG_MSG(logERR, "Could not create snapshot file '%s': %s",
+                SNAP_FILE_TMP, sErr);
+        return false;
+    }
+    fOut.write(buf.data(), std::streamsize(buf.size()));
+    fOut.close();
+    if (!fOut) {
+        LOG_MSG(logERR, "Could not write snapshot file '%s'", SNAP_FILE_TMP);
+        return false;
+    }
+
+    // then replace the previous snapshot
+    std::remove(SNAP_FILE_NAME);
+    if (std::rename(SNAP_FILE_TMP, SNAP_FILE_NAME) != 0) {
+        LOG_MSG(logERR, "Could not rename snapshot file '%s' to '%s'",
+                SNAP_FILE_TMP, SNAP_FILE_NAME);
+        return false;
+    }
+    LOG_MSG(logDEBUG, "Saved snapshot of %lu aircraft in %lu bytes",
+            (unsigned long)nAc, (unsigned long)buf.size());
+    return true;
+}
+
+/// Wait for a running snapshot thread to finish
+static void SnapshotJoin ()
+{
+    if (gSnapThr.joinable()) {
+        gSnapThr.join();
+        gSnapThr = std::thread();
+    }
+}
+
+/// Main thread: Collect the snapshot, then write it in a separate thread
+static void SnapshotSaveAsync ()
+{
+    // Previous save still running? Then skip this one, the next period will catch up
+    if (gbSnapWriting)
+        return;
+    SnapshotJoin();
+
+    size_t nAc = 0;
+    std::string buf = SnapshotCollect(nAc);
+    if (buf.empty())
+        return;
+    gbSnapWriting = true;
+    gSnapThr = std::thread([](std::string b, size_t n)
+    {
+        SET_THREAD_NAME(XPPLANES "_Snapshot");
+        SnapshotWrite(b, n);
+        gbSnapWriting = false;
+    }, std::move(buf), nAc);
+}
+
+/// Read the snapshot file and add all records, which are not yet outdated, to the flight data map
+static void SnapshotRestore ()
+{
+    std::ifstream fIn (SNAP_FILE_NAME, std::ios_base::in | std::ios_base::binary);
+    if (!fIn)                                           // no snapshot is just fine
+        return;
+
+    // Validate the header
+    SnapHeaderTy hdr;
+    if (!fIn.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) ||
+        std::memcmp(hdr.magic, SNAP_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != SNAP_VERSION ||
+        hdr.recSize != sizeof(SnapRecTy))
+    {
+        LOG_MSG(logWARN, "Snapshot file '%s' has an unsupported format, ignored", SNAP_FILE_NAME);
+        return;
+    }
+
+    // Read all records, skipping those already older than the grace period
+    const tsTy cutOff = std::chrono::system_clock::now() - std::chrono::seconds(glob.gracePeriod);
+    std::vector<ptrFlightDataTy> vecFD;
+    vecFD.reserve(hdr.count);
+    for (uint32_t i = 0; i < hdr.count; ++i) {
+        ptrFlightDataTy pFD = SnapGetRec(fIn);
+        if (!pFD) {
+            LOG_MSG(logWARN, "Snapshot file '%s' is truncated after %u records", SNAP_FILE_NAME, i);
+            break;
+        }
+        if (pFD->ts < cutOff || !pFD->IsUsable())
+            continue;
+        pFD->ComputeLabelKey();
+        vecFD.emplace_back(std::move(pFD));
+    }
+
+    // Add them to the flight data map, in the order saved, ie. sorted per aircraft,
+    // applying the same ownship, region, and category filters as to live data
+    std::unordered_set<XPMPPlaneID> setIds;
+    size_t nDropped = 0;
+    FlightDataReadOwnship();
+    {
+        std::lock_guard<std::mutex> guard(glob.mtxListFD);
+        for (ptrFlightDataTy& pFD: vecFD) {
+            if (!FlightDataAcceptRestored(*pFD)) {
+                ++nDropped;
+                continue;
+            }
+            listFlightDataTy& listFD = glob.mapListFD[pFD->_modeS_id];
+            if (listFD.empty() ||
+                listFD.back()->ts + FlightDataMinTsDiff() <= pFD->ts)
+            {
+                setIds.insert(pFD->_modeS_id);
+                glob.setDirtyFD.insert(pFD->_modeS_id);
+                listFD.emplace_back(std::move(pFD));
+            }
+        }
+    }
+    LOG_MSG(logINFO, "Restored %lu aircraft from snapshot, %lu records were outdated, %lu filtered",
+            (unsigned long)setIds.size(), (unsigned long)(hdr.count - vecFD.size()),
+            (unsigned long)nDropped);
+}
+
+//
+// MARK: Global Functions
+//
+
+// Restore the traffic snapshot, if any, into the flight data map
+bool SnapshotStartup ()
+{
+    gSnapLastSave = std::chrono::steady_clock::now();
+    if (glob.snapshotInterval > 0)
+        SnapshotRestore();
+    return true;
+}
+
+// Save the current traffic state, called before flight data and planes are cleaned up
+void SnapshotShutdown ()
+{
+    SnapshotJoin();
+    if (glob.snapshotInterval > 0) {
+        size_t nAc = 0;
+        const std::string buf = SnapshotCollect(nAc);
+        if (!buf.empty())
+            SnapshotWrite(buf, nAc);
+    }
+}
+
+// Regularly called to save the current traffic state every `SnapshotInterval` seconds
+void SnapshotPeriodic ()
+{
+    if (glob.snapshotInterval <= 0 ||
+        std::chrono::steady_clock::now() - gSnapLastSave < std::chrono::seconds(glob.snapshotInterval))
+        return;
+    gSnapLastSave = std::chrono::steady_clock::now();
+    SnapshotSaveAsync();
+}
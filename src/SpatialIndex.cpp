@@ -0,0 +1,261 @@
+/// @file       SpatialIndex.cpp
+/// @brief      Spatial index of all live planes for nearest-neighbour and radius queries
+/// @details    Uniform grid over the local x/z plane. Each plane is registered
+///             with its cell, updates only move a plane between cells when it
+///             crossed a cell border. Queries search outward from the query point's
+///             cell, so they don't need to scan all planes.
+///             The nearest planes around the camera and around the user's aircraft
+///             are also provided as array dataRefs.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: Spatial Grid
+//
+
+// Add a plane or update its position
+void SpatialGridTy::Update (XPMPPlaneID id, float x, float z)
+{
+    const uint64_t cell = CellKey(CellIdx(x), CellIdx(z));
+    auto res = entries.try_emplace(id);
+    EntryTy& e = res.first->second;
+    e.x = x;
+    e.z = z;
+    // Unchanged cell? Then we're done already
+    if (!res.second && e.cell == cell)
+        return;
+    // Move from old to new cell
+    if (!res.second) {
+        auto iterCell = cells.find(e.cell);
+        if (iterCell != cells.end()) {
+            std::vector<XPMPPlaneID>& v = iterCell->second;
+            auto iterId = std::find(v.begin(), v.end(), id);
+            if (iterId != v.end()) {
+                *iterId = v.back();
+                v.pop_back();
+            }
+            if (v.empty())
+                cells.erase(iterCell);
+        }
+    }
+    e.cell = cell;
+    cells[cell].push_back(id);
+}
+
+// Remove a plane
+void SpatialGridTy::Remove (XPMPPlaneID id)
+{
+    auto iter = entries.find(id);
+    if (iter == entries.end()) return;
+    auto iterCell = cells.find(iter->second.cell);
+    if (iterCell != cells.end()) {
+        std::vector<XPMPPlaneID>& v = iterCell->second;
+        auto iterId = std::find(v.begin(), v.end(), id);
+        if (iterId != v.end()) {
+            *iterId = v.back();
+            v.pop_back();
+        }
+        if (v.empty())
+            cells.erase(iterCell);
+    }
+    entries.erase(iter);
+}
+
+// Remove all planes
+void SpatialGridTy::Clear ()
+{
+    entries.clear();
+    cells.clear();
+}
+
+// Ids of all registered planes
+void SpatialGridTy::GetIds (std::vector<XPMPPlaneID>& out) const
+{
+    out.clear();
+    out.reserve(entries.size());
+    for (const auto& e: entries)
+        out.push_back(e.first);
+}
+
+// Add all planes of the given cell to `out`, returns number of planes in the cell
+size_t SpatialGridTy::CollectCell (long ix, long iz, float x, float z, vecSpatialHitTy& out) const
+{
+    auto iterCell = cells.find(CellKey(ix, iz));
+    if (iterCell == cells.end()) return 0;
+    for (XPMPPlaneID id: iterCell->second) {
+        const EntryTy& e = entries.at(id);
+        out.push_back({ std::hypot(e.x - x, e.z - z), id });
+    }
+    return iterCell->second.size();
+}
+
+// Add all planes to `out`
+void SpatialGridTy::CollectAll (float x, float z, vecSpatialHitTy& out) const
+{
+    out.reserve(entries.size());
+    for (const auto& p: entries)
+        out.push_back({ std::hypot(p.second.x - x, p.second.z - z), p.first });
+}
+
+// Up to `k` nearest planes to the given point
+void SpatialGridTy::Nearest (float x, float z, size_t k, vecSpatialHitTy& out) const
+{
+    out.clear();
+    if (!k || entries.empty()) return;
+    
+    // Search ring by ring around the query point's cell
+    const long cx = CellIdx(x);
+    const long cz = CellIdx(z);
+    size_t nSeen = 0;
+    for (long ring = 0; nSeen < entries.size(); ++ring)
+    {
+        // If the ring has more cells than there are planes, then a full scan is cheaper
+        if (size_t(8 * ring) > entries.size()) {
+            out.clear();
+            CollectAll(x, z, out);
+            break;
+        }
+        
+        // Visit the cells on the ring's perimeter
+        if (ring == 0)
+            nSeen += CollectCell(cx, cz, x, z, out);
+        else {
+            for (long ix = cx - ring; ix <= cx + ring; ++ix) {
+                nSeen += CollectCell(ix, cz - ring, x, z, out);
+                nSeen += CollectCell(ix, cz + ring, x, z, out);
+            }
+            for (long iz = cz - ring + 1; iz <= cz + ring - 1; ++iz) {
+                nSeen += CollectCell(cx - ring, iz, x, z, out);
+                nSeen += CollectCell(cx + ring, iz, x, z, out);
+            }
+        }
+        
+        // All planes within `ring` cells' distance have been seen now,
+        // so if the k-th nearest is within that distance we are done
+        if (out.size() >= k) {
+            std::nth_element(out.begin(), out.begin() + long(k-1), out.end());
+            if (out[k-1].dist <= float(ring) * SPATIAL_CELL_M)
+                break;
+        }
+    }
+    
+    // Sort and limit to k
+    if (out.size() > k) {
+        std::partial_sort(out.begin(), out.begin() + long(k), out.end());
+        out.resize(k);
+    } else
+        std::sort(out.begin(), out.end());
+}
+
+// All planes within the given radius around the point
+void SpatialGridTy::Radius (float x, float z, float r, vecSpatialHitTy& out) const
+{
+    out.clear();
+    if (entries.empty() || r < 0.0f) return;
+    
+    // Visit all cells overlapping the search circle's bounding square,
+    // unless there are more cells than planes, then a full scan is cheaper
+    const long x0 = CellIdx(x - r), x1 = CellIdx(x + r);
+    const long z0 = CellIdx(z - r), z1 = CellIdx(z + r);
+    if (size_t(x1 - x0 + 1) * size_t(z1 - z0 + 1) > entries.size())
+        CollectAll(x, z, out);
+    else {
+        for (long ix = x0; ix <= x1; ++ix)
+            for (long iz = z0; iz <= z1; ++iz)
+                CollectCell(ix, iz, x, z, out);
+    }
+    
+    // Remove all beyond the radius, then sort
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [r](const SpatialHitTy& h){ return h.dist > r; }),
+              out.end());
+    std::sort(out.begin(), out.end());
+}
+
+//
+// MARK: Nearest planes, cached per frame
+//
+
+/// Per-frame cache of a nearest query
+struct SpatialNearestCacheTy {
+    int             cycle = -1;     ///< X-Plane's cycle number the result is valid for
+    vecSpatialHitTy hits;           ///< the result
+};
+
+// Nearest planes to the camera, cached per frame
+const vecSpatialHitTy& SpatialNearestToCamera ()
+{
+    static SpatialNearestCacheTy cache;
+    const int cycle = XPLMGetCycleNumber();
+    if (cache.cycle != cycle) {
+        XPLMCameraPosition_t cam;
+        XPLMReadCameraPosition(&cam);
+        glob.spatial.Nearest(cam.x, cam.z, SPATIAL_DR_MAX_N, cache.hits);
+        cache.cycle = cycle;
+    }
+    return cache.hits;
+}
+
+// Nearest planes to the user's aircraft, cached per frame
+const vecSpatialHitTy& SpatialNearestToUser ()
+{
+    static SpatialNearestCacheTy cache;
+    static XPLMDataRef drLocalX = XPLMFindDataRef("sim/flightmodel/position/local_x");
+    static XPLMDataRef drLocalZ = XPLMFindDataRef("sim/flightmodel/position/local_z");
+    const int cycle = XPLMGetCycleNumber();
+    if (cache.cycle != cycle) {
+        glob.spatial.Nearest(float(XPLMGetDatad(drLocalX)), float(XPLMGetDatad(drLocalZ)),
+                             SPATIAL_DR_MAX_N, cache.hits);
+        cache.cycle = cycle;
+    }
+    return cache.hits;
+}
+
+/// Copy values out of a query result following XPLM's array dataRef semantics
+template <class T, class F>
+int SpatialDRCopy (const vecSpatialHitTy& hits, T* outValues, int inOffset, int inMax, F fVal)
+{
+    const int n = int(hits.size());
+    if (!outValues) return n;                       // just the size requested
+    int i = 0;
+    for (; i < inMax && inOffset + i < n; ++i)
+        outValues[i] = fVal(hits[size_t(inOffset + i)]);
+    return i;
+}
+
+// dataRef callback: ids of the nearest planes to the camera
+int SpatialDRCameraIds (int* outValues, int inOffset, int inMax)
+{ return SpatialDRCopy(SpatialNearestToCamera(), outValues, inOffset, inMax,
+                       [](const SpatialHitTy& h){ return int(h.id); }); }
+
+// dataRef callback: distances of the nearest planes to the camera
+int SpatialDRCameraDist (float* outValues, int inOffset, int inMax)
+{ return SpatialDRCopy(SpatialNearestToCamera(), outValues, inOffset, inMax,
+                       [](const SpatialHitTy& h){ return h.dist; }); }
+
+// dataRef callback: ids of the nearest planes to the user's aircraft
+int SpatialDRUserIds (int* outValues, int inOffset, int inMax)
+{ return SpatialDRCopy(SpatialNearestToUser(), outValues, inOffset, inMax,
+                       [](const SpatialHitTy& h){ return int(h.id); }); }
+
+// dataRef callback: distances of the nearest planes to the user's aircraft
+int SpatialDRUserDist (float* outValues, int inOffset, int inMax)
+{ return SpatialDRCopy(SpatialNearestToUser(), outValues, inOffset, inMax,
+                       [](const SpatialHitTy& h){ return h.dist; }); }
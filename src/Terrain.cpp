@@ -0,0 +1,331 @@
+/// @file       Terrain.cpp
+/// @brief      Terrain elevation cache for aircraft on the ground
+/// @details    Ground altitude is sampled on a regular geographic grid, grouped into tiles.
+///             Lookups interpolate bilinearly between the four surrounding samples.
+///             Samples not yet in the cache are queued, and the queue is worked off
+///             nearest-to-camera first within a time budget per flight loop.
+///             The cache is invalidated when scenery is reloaded.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: Cache definition
+//
+
+/// Distance between two samples in degrees (used for latitude and longitude alike, so cells become narrower towards the poles)
+constexpr double TERRAIN_CELL_DEG = TERRAIN_CELL_M / 111120.0;
+
+/// One tile of the cache, holding sampled ground altitudes [m MSL], `NAN` if not yet probed
+struct TerrainTileTy {
+    /// Samples, one more per side than cells so that every cell has all its 4 corners in the same tile
+    float alt[TERRAIN_TILE_CELLS+1][TERRAIN_TILE_CELLS+1];
+    /// Constructor initializes all samples to `NAN`
+    TerrainTileTy () { std::fill_n(&alt[0][0], (TERRAIN_TILE_CELLS+1)*(TERRAIN_TILE_CELLS+1), NAN); }
+};
+
+/// Map of tiles, key combines the tile's latitude and longitude index
+typedef std::unordered_map<uint64_t, TerrainTileTy> mapTerrainTilesTy;
+
+// module-global variables
+static mapTerrainTilesTy gTiles;                ///< the cache
+static XPLMProbeRef gProbe = nullptr;           ///< terrain probe object
+static int gHits = 0;                           ///< number of lookups answered from the cache
+static int gMisses = 0;                         ///< number of lookups which had to wait for probes
+static int gProbes = 0;                         ///< number of terrain probes performed
+static float gCamGndAlt = NAN;                  ///< ground altitude below the camera [m MSL], see TerrainCameraGndAlt()
+static int gCamGndCycle = -1;                   ///< flight loop cycle, in which `gCamGndAlt` was probed
+
+/// Integer division rounding towards negative infinity
+inline long floorDiv (long a, long b)
+{ return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+/// Key combining two 32 bit indexes (of a tile or of a sample)
+inline uint64_t TerrainKey (long iLat, long iLon)
+{ return (uint64_t(uint32_t(iLat)) << 32) | uint64_t(uint32_t(iLon)); }
+
+/// Find or create the tile with given indexes
+static TerrainTileTy& TerrainTile (long tLat, long tLon)
+{
+    // Limit memory usage: If the cache becomes too large we start over
+    if (gTiles.size() >= TERRAIN_MAX_TILES) {
+        LOG_MSG(logDEBUG, "Terrain cache full with %lu tiles, flushing", (unsigned long)gTiles.size());
+        gTiles.clear();
+    }
+    return gTiles[TerrainKey(tLat, tLon)];
+}
+
+/// Probe terrain at given position, returns ground altitude [m MSL], `NAN` if the probe missed
+static float TerrainProbe (double lat, double lon)
+{
+    // Make sure we have a probe object
+    if (!gProbe)
+        gProbe = XPLMCreateProbe(xplm_ProbeY);
+    LOG_ASSERT(gProbe);
+    ++gProbes;
+    
+    // Convert lat/lon to OpenGL
+    double X = 0.0, Y = 0.0, Z = 0.0;
+    ProjWorldToLocal(lat, lon, 0.0, X, Y, Z);
+    
+    // Where's the ground?
+    XPLMProbeInfo_t infoProbe = {
+        sizeof(XPLMProbeInfo_t),            // structSIze
+        0.0f, 0.0f, 0.0f,                   // location
+        0.0f, 0.0f, 0.0f,                   // normal vector
+        0.0f, 0.0f, 0.0f,                   // velocity vector
+        0                                   // is_wet
+    };
+    if (XPLMProbeTerrainXYZ(gProbe,
+                            float(X), float(Y), float(Z),
+                            &infoProbe) == xplm_ProbeHitTerrain)
+    {
+        // Return the altitude back to world coordinates
+        double alt_m = 0.0;
+        ProjLocalToWorld(double(infoProbe.locationX),
+                         double(infoProbe.locationY),
+                         double(infoProbe.locationZ),
+                         X, Y, alt_m);
+        return float(alt_m);
+    }
+    // probe failed, e.g. as scenery isn't loaded there (yet)
+    return NAN;
+}
+
+//
+// MARK: Probe queue
+//
+
+/// A sample waiting to be probed
+struct TerrainReqTy {
+    long    sLat = 0;               ///< sample's latitude index
+    long    sLon = 0;               ///< sample's longitude index
+    double  dist2 = 0.0;            ///< (squared, unscaled) distance to camera, for sorting
+};
+
+static std::vector<TerrainReqTy> gQueue;        ///< samples waiting to be probed
+static std::unordered_set<uint64_t> gQueued;    ///< keys of samples in `gQueue`, avoids duplicates
+
+/// Queue a sample for probing unless already queued
+static void TerrainEnqueue (long sLat, long sLon)
+{
+    if (gQueued.insert(TerrainKey(sLat, sLon)).second)
+        gQueue.push_back({ sLat, sLon, 0.0 });
+}
+
+//
+// MARK: Global Functions
+//
+
+// Ground altitude [m MSL] at given position, from cache only
+bool TerrainTryGetAlt (double lat, double lon, double& alt_m, bool bRetry)
+{
+    // Which cell, which tile?
+    const double fLat = lat / TERRAIN_CELL_DEG;
+    const double fLon = lon / TERRAIN_CELL_DEG;
+    const long sLat = long(std::floor(fLat));
+    const long sLon = long(std::floor(fLon));
+    const long tLat = floorDiv(sLat, TERRAIN_TILE_CELLS);
+    const long tLon = floorDiv(sLon, TERRAIN_TILE_CELLS);
+    TerrainTileTy& tile = TerrainTile(tLat, tLon);
+    
+    // Are all 4 corners of the cell known? Queue those which aren't
+    const int i = int(sLat - tLat * TERRAIN_TILE_CELLS);
+    const int j = int(sLon - tLon * TERRAIN_TILE_CELLS);
+    bool bMissing = false;
+    for (int di = 0; di <= 1; ++di) {
+        for (int dj = 0; dj <= 1; ++dj) {
+            if (std::isnan(tile.alt[i+di][j+dj])) {
+                TerrainEnqueue(sLat+di, sLon+dj);
+                bMissing = true;
+            }
+        }
+    }
+    if (bMissing) {
+        if (!bRetry) ++gMisses;
+        return false;
+    }
+    if (!bRetry) ++gHits;
+    
+    // Bilinear interpolation between the 4 corners
+    const double u = fLat - double(sLat);
+    const double v = fLon - double(sLon);
+    alt_m =
+    (1.0-u) * ((1.0-v) * double(tile.alt[i  ][j]) + v * double(tile.alt[i  ][j+1])) +
+         u  * ((1.0-v) * double(tile.alt[i+1][j]) + v * double(tile.alt[i+1][j+1]));
+    return true;
+}
+
+// Best guess of the ground altitude from nearby known samples
+bool TerrainGuessAlt (double lat, double lon, double& alt_m)
+{
+    const double fLat = lat / TERRAIN_CELL_DEG;
+    const double fLon = lon / TERRAIN_CELL_DEG;
+    const long tLat = floorDiv(long(std::floor(fLat)), TERRAIN_TILE_CELLS);
+    const long tLon = floorDiv(long(std::floor(fLon)), TERRAIN_TILE_CELLS);
+    auto iter = gTiles.find(TerrainKey(tLat, tLon));
+    if (iter == gTiles.end())
+        return false;
+    
+    // Nearest known sample in the tile
+    const double u = fLat - double(tLat * TERRAIN_TILE_CELLS);
+    const double v = fLon - double(tLon * TERRAIN_TILE_CELLS);
+    double bestDist2 = HUGE_VAL;
+    float bestAlt = NAN;
+    for (int i = 0; i <= TERRAIN_TILE_CELLS; ++i) {
+        for (int j = 0; j <= TERRAIN_TILE_CELLS; ++j) {
+            const float alt = iter->second.alt[i][j];
+            if (std::isnan(alt)) continue;
+            const double dist2 = (double(i)-u)*(double(i)-u) + (double(j)-v)*(double(j)-v);
+            if (dist2 < bestDist2) {
+                bestDist2 = dist2;
+                bestAlt = alt;
+            }
+        }
+    }
+    if (std::isnan(bestAlt))
+        return false;
+    alt_m = double(bestAlt);
+    return true;
+}
+
+// Main thread only: Ground altitude below the camera [m MSL], probed at most once per flight loop cycle
+float TerrainCameraGndAlt ()
+{
+    const int cycle = XPLMGetCycleNumber();
+    if (cycle != gCamGndCycle) {
+        gCamGndCycle = cycle;
+        XPLMCameraPosition_t cam;
+        XPLMReadCameraPosition(&cam);
+        double camLat = 0.0, camLon = 0.0, camAlt = 0.0;
+        ProjLocalToWorld(double(cam.x), double(cam.y), double(cam.z),
+                         camLat, camLon, camAlt);
+        gCamGndAlt = TerrainProbe(camLat, camLon);
+    }
+    return gCamGndAlt;
+}
+
+// Process queued probes, nearest to camera first, within the configured time budget
+void TerrainProcessQueue ()
+{
+    if (gQueue.empty()) return;
+    const auto tStart = std::chrono::steady_clock::now();
+    const auto tEnd = tStart + std::chrono::microseconds(glob.terrainProbeBudget);
+    
+    // Sort by distance to the camera, nearest last so we can pop from the back
+    if (gQueue.size() > 1) {
+        XPLMCameraPosition_t cam;
+        XPLMReadCameraPosition(&cam);
+        double camLat = 0.0, camLon = 0.0, camAlt = 0.0;
+        ProjLocalToWorld(double(cam.x), double(cam.y), double(cam.z),
+                         camLat, camLon, camAlt);
+        const double sLatCam = camLat / TERRAIN_CELL_DEG;
+        const double sLonCam = camLon / TERRAIN_CELL_DEG;
+        const double cosLat = std::cos(deg2rad(camLat));
+        for (TerrainReqTy& req: gQueue) {
+            const double dLat = double(req.sLat) - sLatCam;
+            const double dLon = (double(req.sLon) - sLonCam) * cosLat;
+            req.dist2 = dLat*dLat + dLon*dLon;
+        }
+        std::sort(gQueue.begin(), gQueue.end(),
+                  [](const TerrainReqTy& a, const TerrainReqTy& b){ return a.dist2 > b.dist2; });
+    }
+    
+    // Probe until the budget is used up, but at least once so we always make progress
+    do {
+        const TerrainReqTy req = gQueue.back();
+        gQueue.pop_back();
+        gQueued.erase(TerrainKey(req.sLat, req.sLon));
+        
+        const long tLat = floorDiv(req.sLat, TERRAIN_TILE_CELLS);
+        const long tLon = floorDiv(req.sLon, TERRAIN_TILE_CELLS);
+        const float alt = TerrainProbe(double(req.sLat) * TERRAIN_CELL_DEG,
+                                       double(req.sLon) * TERRAIN_CELL_DEG);
+        // A miss is never cached: the sample stays unknown, planes keep their provisional
+        // altitude, and the sample gets queued again with the planes' next lookup
+        if (std::isnan(alt))
+            continue;
+        // store the result in its own tile and in the neighbouring tiles' overlapping border
+        for (long dt = 0; dt <= 1; ++dt) {
+            for (long du = 0; du <= 1; ++du) {
+                const int i = int(req.sLat - (tLat-dt) * TERRAIN_TILE_CELLS);
+                const int j = int(req.sLon - (tLon-du) * TERRAIN_TILE_CELLS);
+                if (i > TERRAIN_TILE_CELLS || j > TERRAIN_TILE_CELLS)
+                    continue;
+                if (dt || du) {
+                    // only update neighbouring tiles which already exist
+                    auto iter = gTiles.find(TerrainKey(tLat-dt, tLon-du));
+                    if (iter != gTiles.end())
+                        iter->second.alt[i][j] = alt;
+                }
+                else
+                    TerrainTile(tLat, tLon).alt[i][j] = alt;
+            }
+        }
+    } while (!gQueue.empty() && std::chrono::steady_clock::now() < tEnd);
+}
+
+// Invalidate the cache, e.g. after scenery reload
+void TerrainCacheClear ()
+{
+    if (!gTiles.empty()) {
+        LOG_MSG(logDEBUG, "Terrain cache invalidated, %lu tiles removed", (unsigned long)gTiles.size());
+    }
+    gTiles.clear();
+}
+
+// Number of lookups answered from the cache alone
+int TerrainCacheHits ()
+{ return gHits; }
+
+// Number of lookups which had to wait for terrain probes
+int TerrainCacheMisses ()
+{ return gMisses; }
+
+// Share of lookups answered from the cache alone
+float TerrainCacheHitRate ()
+{ return gHits + gMisses > 0 ? float(gHits) / float(gHits + gMisses) : 0.0f; }
+
+// Number of terrain probes performed
+int TerrainProbeCount ()
+{ return gProbes; }
+
+// Number of samples waiting to be probed
+int TerrainQueueLength ()
+{ return int(gQueue.size()); }
+
+// Initialize the Terrain module
+bool TerrainStartup ()
+{
+    gHits = gMisses = gProbes = 0;
+    return true;
+}
+
+// Shutdown the Terrain module, frees all resources
+void TerrainShutdown ()
+{
+    gTiles.clear();
+    gCamGndAlt = NAN;
+    gCamGndCycle = -1;
+    gQueue.clear();
+    gQueued.clear();
+    if (gProbe)
+        XPLMDestroyProbe(gProbe);
+    gProbe = nullptr;
+}
@@ -0,0 +1,135 @@
+/// @file       TimerWheel.cpp
+/// @brief      Hierarchical timer wheel for expiry of aircraft without fresh data
+/// @details    Each aircraft has one deadline. Deadlines are sorted into slots of
+///             several wheel levels with increasing granularity, and are cascaded
+///             down to finer levels as time approaches. Advancing the wheel only
+///             touches the slots passed, so expiry costs O(expired).
+///             Extending a deadline is lazy: The entry stays in its slot and is
+///             only moved once its original time is reached.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: Timer Wheel
+//
+
+// Set or move the deadline of an aircraft
+void TimerWheelTy::Schedule (XPMPPlaneID id, const tsTy& deadline)
+{
+    const tickTy t = ToTick(deadline);
+    if (!bInit) {
+        curr = ToTick(std::chrono::system_clock::now());
+        bInit = true;
+    }
+    
+    auto res = entries.try_emplace(id);
+    EntryTy& e = res.first->second;
+    e.deadline = t;
+    // New entries and earlier deadlines need (re)insertion,
+    // later deadlines are handled lazily once the scheduled slot is reached
+    if (res.second || t < e.scheduled)
+        Insert(id, e);
+}
+
+// Advance the wheel up to `now`
+void TimerWheelTy::Advance (const tsTy& now, std::vector<XPMPPlaneID>& expired)
+{
+    const tickTy tNow = ToTick(now);
+    if (!bInit) {
+        curr = tNow;
+        bInit = true;
+    }
+    
+    for (; curr <= tNow; ++curr)
+    {
+        // Level 0 wrapped around? Then bring down the next entries from the higher levels
+        if ((curr & (LVL_SLOTS-1)) == 0)
+            Cascade(1);
+        
+        // Process the current slot, swap it out as expired entries might be re-inserted
+        std::vector<XPMPPlaneID> slot;
+        slot.swap(slots[0][curr & (LVL_SLOTS-1)]);
+        for (XPMPPlaneID id: slot) {
+            auto iter = entries.find(id);
+            if (iter == entries.end() ||            // cancelled
+                iter->second.scheduled != curr)     // moved elsewhere
+                continue;
+            if (iter->second.deadline > curr)       // deadline was extended
+                Insert(id, iter->second);
+            else {
+                expired.push_back(id);
+                entries.erase(iter);
+            }
+        }
+        // Keep the slot's capacity for reuse
+        slot.clear();
+        if (slots[0][curr & (LVL_SLOTS-1)].empty())
+            slots[0][curr & (LVL_SLOTS-1)].swap(slot);
+    }
+}
+
+// Remove all aircraft
+void TimerWheelTy::Clear ()
+{
+    entries.clear();
+    for (auto& lvl: slots)
+        for (auto& slot: lvl)
+            slot.clear();
+    bInit = false;
+}
+
+// Insert an entry into the slot corresponding to its deadline
+void TimerWheelTy::Insert (XPMPPlaneID id, EntryTy& e)
+{
+    // Past deadlines are due with the next processed tick,
+    // too far future ones are parked at the furthest possible tick
+    tickTy t = std::max(e.deadline, curr);
+    if (t - curr > MAX_DELTA)
+        t = curr + MAX_DELTA;
+    e.scheduled = t;
+    
+    // Find the level: the finest one that covers the distance
+    const tickTy delta = t - curr;
+    int lvl = 0;
+    while (lvl < LEVELS-1 && delta >= (tickTy(1) << (LVL_BITS * (lvl+1))))
+        ++lvl;
+    slots[lvl][(t >> (LVL_BITS * lvl)) & (LVL_SLOTS-1)].push_back(id);
+}
+
+// Move all entries of the current slot of level `lvl` down to finer levels
+void TimerWheelTy::Cascade (int lvl)
+{
+    if (lvl >= LEVELS) return;
+    const tickTy idx = (curr >> (LVL_BITS * lvl)) & (LVL_SLOTS-1);
+    // This level wrapped around, too? Then first bring down the next level's entries
+    if (idx == 0)
+        Cascade(lvl+1);
+    
+    std::vector<XPMPPlaneID> slot;
+    slot.swap(slots[lvl][idx]);
+    for (XPMPPlaneID id: slot) {
+        // Re-insert if still belonging to this slot (otherwise it was moved elsewhere),
+        // this also moves entries, which are more than one round ahead, back to where they belong
+        auto iter = entries.find(id);
+        if (iter != entries.end() &&
+            ((iter->second.scheduled >> (LVL_BITS * lvl)) & (LVL_SLOTS-1)) == idx)
+            Insert(id, iter->second);
+    }
+}
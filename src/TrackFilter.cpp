@@ -0,0 +1,328 @@
+/// @file       TrackFilter.cpp
+/// @brief      Kalman filter smoothing noisy positions per aircraft in the ingest path
+/// @details    An extended Kalman filter with a constant turn rate and velocity (CTRV) model
+///             estimates position, ground speed, track, and track rate in a local
+///             east/north plane, a separate linear Kalman filter estimates
+///             altitude and vertical speed. Runs on the network thread as data arrives,
+///             replaces the received position by the filtered one, and annotates
+///             the data with the estimated velocities.
+/// @author     Birger Hoppe
+/// @copyright  (c) 2022 Birger Hoppe
+/// @copyright  Permission is hereby granted, free of charge, to any person obtaining a
+///             copy of this software and associated documentation files (the "Software"),
+///             to deal in the Software without restriction, including without limitation
+///             the rights to use, copy, modify, merge, publish, distribute, sublicense,
+///             and/or sell copies of the Software, and to permit persons to whom the
+///             Software is furnished to do so, subject to the following conditions:\n
+///             The above copyright notice and this permission notice shall be included in
+///             all copies or substantial portions of the Software.\n
+///             THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+///             IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+///             FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+///             AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+///             LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+///             OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+///             THE SOFTWARE.
+
+#include "XPPlanes.h"
+
+//
+// MARK: Helpers
+//
+
+/// Total time spent filtering [us], guarded by `glob.mtxListFD` like all filters
+static double gFilterUs = 0.0;
+/// Number of records filtered
+static long gFilterN = 0;
+
+/// Normalize an angle to [-pi; pi)
+static double NormAngle (double a)
+{
+    a = std::fmod(a + PI, 2.0 * PI);
+    if (a < 0.0) a += 2.0 * PI;
+    return a - PI;
+}
+
+//
+// MARK: Track Filter
+//
+
+// Filter a record in place, must be called in timestamp order
+void TrackFilterTy::Process (FlightData& fd)
+{
+    const auto tStart = std::chrono::steady_clock::now();
+
+    // First record, or too long a gap? (Re)start the filter
+    const double dt = std::chrono::duration<double>(fd.ts - tsLast).count();
+    bool bInit = false;
+    if (std::isnan(lat0) || dt > FILTER_MAX_GAP) {
+        Init(fd);
+        bInit = true;
+    }
+    // Out-of-order or same-time data passes unchanged
+    else if (dt < FILTER_MIN_DT) {
+        return;
+    }
+    else {
+        // Predict to the record's time
+        Predict(dt);
+
+        // Measured position in our local plane
+        const double zx = deg2rad(fd.lon - lon0) * EARTH_RADIUS_M * std::cos(deg2rad(lat0));
+        const double zy = deg2rad(fd.lat - lat0) * EARTH_RADIUS_M;
+
+        // A position way off the prediction is rather a new start than noise
+        if (std::abs(zx - x[SX]) > FILTER_MAX_RESIDUAL ||
+            std::abs(zy - x[SY]) > FILTER_MAX_RESIDUAL) {
+            Init(fd);
+            bInit = true;
+        }
+        // Without given speed and track the filter would hardly find them from positions alone
+        else if (!bVelValid) {
+            InitVel(zx, zy, dt);
+            InitAlt(fd);
+            bInit = true;
+        }
+        else {
+            const double rPos = double(glob.filterPosNoise) * double(glob.filterPosNoise);
+            Update(SX, zx, rPos);
+            Update(SY, zy, rPos);
+            if (!std::isnan(fd.gs_m))
+                Update(SV, fd.gs_m, FILTER_SPEED_NOISE * FILTER_SPEED_NOISE);
+            if (!std::isnan(fd.track))
+                Update(SPSI, deg2rad(fd.track), FILTER_TRACK_NOISE * FILTER_TRACK_NOISE);
+            if (!std::isnan(fd.trackRate))
+                Update(SW, deg2rad(fd.trackRate), FILTER_TURN_NOISE * FILTER_TURN_NOISE);
+            ProcessAlt(fd, dt);
+        }
+    }
+    tsLast = fd.ts;
+
+    // Keep the local plane small so its flat earth assumption holds
+    if (std::abs(x[SX]) > FILTER_REBASE_DIST || std::abs(x[SY]) > FILTER_REBASE_DIST)
+        Rebase();
+
+    // Output the estimate, unless the filter just started, then the record stays as is
+    if (!bInit) {
+        fd.lat          = lat0 + rad2deg(x[SY] / EARTH_RADIUS_M);
+        fd.lon          = lon0 + rad2deg(x[SX] / (EARTH_RADIUS_M * std::cos(deg2rad(lat0))));
+        fd.gs_m         = float(x[SV]);
+        fd.track        = float(rad2deg(NormAngle(x[SPSI])));
+        if (fd.track < 0.0f) fd.track += 360.0f;
+        fd.trackRate    = float(rad2deg(x[SW]));
+        if (bAltValid && !fd.bGnd) {
+            fd.alt_m    = h;
+            fd.vs_m     = float(vh);
+        }
+    }
+
+    gFilterUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tStart).count();
+    ++gFilterN;
+}
+
+// (Re)start the filter from a record
+void TrackFilterTy::Init (const FlightData& fd)
+{
+    lat0 = fd.lat;
+    lon0 = fd.lon;
+    x[SX]   = 0.0;
+    x[SY]   = 0.0;
+    x[SV]   = NZ(fd.gs_m);
+    x[SPSI] = deg2rad(std::isnan(fd.track) ? NZ(fd.heading) : fd.track);
+    x[SW]   = deg2rad(NZ(fd.trackRate));
+
+    // Known values start with their measurement noise, unknown ones with a large uncertainty
+    for (int i = 0; i < SN; ++i)
+        for (int j = 0; j < SN; ++j)
+            P[i][j] = 0.0;
+    P[SX][SX] = P[SY][SY] = double(glob.filterPosNoise) * double(glob.filterPosNoise);
+    P[SV][SV]     = std::isnan(fd.gs_m)      ? 100.0 * 100.0 : FILTER_SPEED_NOISE * FILTER_SPEED_NOISE;
+    P[SPSI][SPSI] = std::isnan(fd.track)     ? PI * PI       : FILTER_TRACK_NOISE * FILTER_TRACK_NOISE;
+    P[SW][SW]     = std::isnan(fd.trackRate) ? 0.05 * 0.05   : FILTER_TURN_NOISE * FILTER_TURN_NOISE;
+
+    bVelValid = !std::isnan(fd.gs_m) && !std::isnan(fd.track);
+    InitAlt(fd);
+}
+
+// Initialize speed and track from the displacement between the first two records
+void TrackFilterTy::InitVel (double zx, double zy, double dt)
+{
+    const double dx = zx - x[SX];
+    const double dy = zy - x[SY];
+    const double rPos = double(glob.filterPosNoise) * double(glob.filterPosNoise);
+    x[SX]   = zx;
+    x[SY]   = zy;
+    x[SV]   = std::sqrt(dx*dx + dy*dy) / dt;
+    x[SPSI] = std::atan2(dx, dy);
+    x[SW]   = 0.0;
+
+    // Speed's variance stems from two noisy positions, track's the same across the speed
+    for (int i = 0; i < SN; ++i)
+        for (int j = 0; j < SN; ++j)
+            P[i][j] = 0.0;
+    P[SX][SX] = P[SY][SY] = rPos;
+    P[SV][SV]     = 2.0 * rPos / (dt * dt);
+    P[SPSI][SPSI] = x[SV] > 1.0 ? std::min(P[SV][SV] / (x[SV] * x[SV]), PI * PI) : PI * PI;
+    P[SW][SW]     = 0.05 * 0.05;
+    bVelValid = true;
+}
+
+// Predict the horizontal state `dt` seconds ahead
+void TrackFilterTy::Predict (double dt)
+{
+    const double v = x[SV], psi = x[SPSI], w = x[SW];
+    const double s0 = std::sin(psi), c0 = std::cos(psi);
+
+    // State transition and its Jacobian F (identity except for the entries set below)
+    double F[SN][SN] = {};
+    for (int i = 0; i < SN; ++i) F[i][i] = 1.0;
+    if (std::abs(w) > 1e-4) {
+        const double psi1 = psi + w * dt;
+        const double s1 = std::sin(psi1), c1 = std::cos(psi1);
+        x[SX] += v / w * (c0 - c1);
+        x[SY] += v / w * (s1 - s0);
+        F[SX][SV]   = (c0 - c1) / w;
+        F[SX][SPSI] = v / w * (s1 - s0);
+        F[SX][SW]   = -v / (w * w) * (c0 - c1) + v / w * s1 * dt;
+        F[SY][SV]   = (s1 - s0) / w;
+        F[SY][SPSI] = v / w * (c1 - c0);
+        F[SY][SW]   = -v / (w * w) * (s1 - s0) + v / w * c1 * dt;
+    } else {
+        x[SX] += v * dt * s0;
+        x[SY] += v * dt * c0;
+        F[SX][SV]   = dt * s0;
+        F[SX][SPSI] = v * dt * c0;
+        F[SX][SW]   = 0.5 * v * dt * dt * c0;
+        F[SY][SV]   = dt * c0;
+        F[SY][SPSI] = -v * dt * s0;
+        F[SY][SW]   = -0.5 * v * dt * dt * s0;
+    }
+    x[SPSI] = NormAngle(x[SPSI] + w * dt);
+    F[SPSI][SW] = dt;
+
+    // P = F P F^T + Q
+    double FP[SN][SN];
+    for (int i = 0; i < SN; ++i)
+        for (int j = 0; j < SN; ++j) {
+            FP[i][j] = 0.0;
+            for (int k = 0; k < SN; ++k)
+                FP[i][j] += F[i][k] * P[k][j];
+        }
+    for (int i = 0; i < SN; ++i)
+        for (int j = 0; j < SN; ++j) {
+            P[i][j] = 0.0;
+            for (int k = 0; k < SN; ++k)
+                P[i][j] += FP[i][k] * F[j][k];
+        }
+
+    // Process noise from random acceleration and random turn acceleration
+    const double G[SN][2] = {
+        { 0.5 * dt * dt * s0,   0.0 },
+        { 0.5 * dt * dt * c0,   0.0 },
+        { dt,                   0.0 },
+        { 0.0,                  0.5 * dt * dt },
+        { 0.0,                  dt },
+    };
+    const double qA = FILTER_ACCEL_NOISE * FILTER_ACCEL_NOISE;
+    const double qW = FILTER_TURN_ACCEL_NOISE * FILTER_TURN_ACCEL_NOISE;
+    for (int i = 0; i < SN; ++i)
+        for (int j = 0; j < SN; ++j)
+            P[i][j] += G[i][0] * G[j][0] * qA + G[i][1] * G[j][1] * qW;
+}
+
+// Update with a measurement of one state component
+void TrackFilterTy::Update (int i, double z, double r)
+{
+    // With a measurement matrix selecting just one component this is
+    // the scalar form of the Kalman update, no matrix inversion needed
+    double y = z - x[i];
+    if (i == SPSI) y = NormAngle(y);
+    const double S = P[i][i] + r;
+    double K[SN];
+    for (int k = 0; k < SN; ++k)
+        K[k] = P[k][i] / S;
+    for (int k = 0; k < SN; ++k)
+        x[k] += K[k] * y;
+    x[SPSI] = NormAngle(x[SPSI]);
+    if (x[SV] < 0.0) x[SV] = 0.0;
+    // P = (I - K H) P, with H selecting component i
+    double Pi[SN];
+    for (int k = 0; k < SN; ++k)
+        Pi[k] = P[i][k];
+    for (int k = 0; k < SN; ++k)
+        for (int j = 0; j < SN; ++j)
+            P[k][j] -= K[k] * Pi[j];
+}
+
+// Start the altitude filter from a record
+void TrackFilterTy::InitAlt (const FlightData& fd)
+{
+    bAltValid = !std::isnan(fd.alt_m);
+    h  = NZ(fd.alt_m);
+    vh = NZ(fd.vs_m);
+    const double rAlt = double(glob.filterAltNoise) * double(glob.filterAltNoise);
+    Ph[0][0] = rAlt;
+    Ph[0][1] = Ph[1][0] = 0.0;
+    Ph[1][1] = std::isnan(fd.vs_m) ? 10.0 * 10.0 : FILTER_VS_NOISE * FILTER_VS_NOISE;
+}
+
+// Predict and update the altitude filter
+void TrackFilterTy::ProcessAlt (const FlightData& fd, double dt)
+{
+    if (std::isnan(fd.alt_m))
+        return;
+    if (!bAltValid || fd.bGnd) {                    // on the ground altitude is determined by terrain anyway
+        InitAlt(fd);
+        return;
+    }
+
+    // Predict with constant vertical speed, random vertical acceleration
+    h += vh * dt;
+    const double q = FILTER_VACCEL_NOISE * FILTER_VACCEL_NOISE;
+    const double p00 = Ph[0][0] + dt * (Ph[1][0] + Ph[0][1]) + dt * dt * Ph[1][1] + q * dt*dt*dt*dt / 4.0;
+    const double p01 = Ph[0][1] + dt * Ph[1][1] + q * dt*dt*dt / 2.0;
+    const double p11 = Ph[1][1] + q * dt * dt;
+    Ph[0][0] = p00; Ph[0][1] = Ph[1][0] = p01; Ph[1][1] = p11;
+
+    // Update with altitude, then vertical speed if given (scalar updates)
+    auto UpdAlt = [&](int i, double z, double r) {
+        const double y = z - (i == 0 ? h : vh);
+        const double S = Ph[i][i] + r;
+        const double K0 = Ph[0][i] / S, K1 = Ph[1][i] / S;
+        h  += K0 * y;
+        vh += K1 * y;
+        const double Pi0 = Ph[i][0], Pi1 = Ph[i][1];
+        Ph[0][0] -= K0 * Pi0; Ph[0][1] -= K0 * Pi1;
+        Ph[1][0] -= K1 * Pi0; Ph[1][1] -= K1 * Pi1;
+    };
+    UpdAlt(0, fd.alt_m, double(glob.filterAltNoise) * double(glob.filterAltNoise));
+    if (!std::isnan(fd.vs_m))
+        UpdAlt(1, fd.vs_m, FILTER_VS_NOISE * FILTER_VS_NOISE);
+}
+
+// Move the origin of the local plane to the current position
+void TrackFilterTy::Rebase ()
+{
+    const double lat = lat0 + rad2deg(x[SY] / EARTH_RADIUS_M);
+    lon0 += rad2deg(x[SX] / (EARTH_RADIUS_M * std::cos(deg2rad(lat0))));
+    lat0 = lat;
+    x[SX] = x[SY] = 0.0;
+}
+
+//
+// MARK: Global Functions
+//
+
+// Average cost of filtering one record [us]
+float TrackFilterCostUs ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return gFilterN > 0 ? float(gFilterUs / double(gFilterN)) : 0.0f;
+}
+
+// Number of aircraft currently tracked by a filter
+int TrackFilterNumAircraft ()
+{
+    std::lock_guard<std::mutex> guard(glob.mtxListFD);
+    return int(glob.mapFilter.size());
+}
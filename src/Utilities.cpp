@@ -80,6 +80,15 @@ float HeadDiff (float from, float to)
     return degDif;
 }
 
+// Move a position along a track by a distance, assuming a spherical earth and short distances
+void GeoMove (double& lat, double& lon, double track, double dist_m)
+{
+    const double ang = dist_m / EARTH_RADIUS_M;
+    const double trk = deg2rad(track);
+    lat += rad2deg(ang * std::cos(trk));
+    lon += rad2deg(ang * std::sin(trk) / std::cos(deg2rad(lat)));
+}
+
 
 // Rotation: Computes new rotation angle based on current + revolution in a (small) amount of time
 float RpmToAngle (float angle, float rpm, float s)
@@ -97,6 +97,9 @@ void ClientReleaseAI ()
 // menu indexes
 constexpr std::uintptr_t MENU_ACTIVE = 0;
 constexpr std::uintptr_t MENU_TCAS   = 1;
+#ifdef XPPLANES_BENCH
+constexpr std::uintptr_t MENU_BENCH  = 2;
+#endif
 
 /// Command definition per menu item
 struct CmdMenuDefTy {
@@ -104,9 +107,12 @@ struct CmdMenuDefTy {
     const char* menuName = nullptr;         ///< (initial) menu item's name
     const char* description = nullptr;      ///< human-readable command description
     XPLMCommandRef hCmd = nullptr;          ///< command reference assigned by X-Plane
-} CMD_MENU_DEF[2] = {
+} CMD_MENU_DEF[] = {
     { XPPLANES "/Activate",  "Active",       "Toggle if " XPPLANES " shall display planes" },
     { XPPLANES "/TCAS",      "TCAS Control", "Toggle if " XPPLANES " shall have TCAS control" },
+#ifdef XPPLANES_BENCH
+    { XPPLANES "/Benchmark", "Run Benchmarks", "Run " XPPLANES "'s benchmarks, results go to Log.txt" },
+#endif
 };
 
 /// Sets all menu checkmarks according to current status
@@ -157,6 +163,11 @@ int CmdCallback (XPLMCommandRef cmdRef, XPLMCommandPhase inPhase, void*)
                 else
                     ClientTryGetAI();
             }
+#ifdef XPPLANES_BENCH
+            else if (cmdRef == CMD_MENU_DEF[MENU_BENCH].hCmd) {
+                BenchmarkRun();
+            }
+#endif
             
             // Update check marks...things might have changed
             MenuUpdateCheckmarks();
@@ -182,6 +193,8 @@ float FlightLoop_Callback(float, float, int, void*)
     try {
         GetMiscNetwTime();              // update rcGlob.now, e.g. for logging from worker threads
         PlaneMaintenance();             // regular plane updates from flight data
+        SnapshotPeriodic();             // regular save of the traffic state
+        ListenFeedback();               // regular feedback to producers
         MenuUpdateCheckmarks();         // update menu
     }
     catch (const std::exception& e) {
@@ -281,6 +294,9 @@ PLUGIN_API int XPluginStart(char *		outName,
     }
 
     MenuUpdateCheckmarks();
+    
+    // Provide our dataRefs
+    DataRefsStartup();
 
     return 1;
 }
@@ -295,8 +311,10 @@ PLUGIN_API int  XPluginEnable(void)
     }
     
     // Startup all modules, bail if one fails
-    if (!PlaneStartup() ||
+    if (!TerrainStartup() ||
+        !PlaneStartup() ||
         !FlightDataStartup() ||
+        !SnapshotStartup() ||
         !ListenStartup())
     {
         LOG_MSG(logFATAL, "One of the modules didn't startup, can't run!");
@@ -333,8 +351,10 @@ PLUGIN_API void XPluginDisable(void)
 
     // Shutdown and cleanup all modules
     ListenShutdown();
+    SnapshotShutdown();
     FlightDataShutdown();
     PlaneShutdown();
+    TerrainShutdown();
     
     // Update the menus
     MenuUpdateCheckmarks();
@@ -347,6 +367,7 @@ PLUGIN_API void XPluginDisable(void)
 PLUGIN_API void XPluginStop(void)
 {
     // Properly clean up
+    DataRefsShutdown();
     XPMPMultiplayerCleanup();
 }
 
@@ -354,7 +375,13 @@ PLUGIN_API void XPluginStop(void)
 /// @see https://developer.x-plane.com/article/developing-plugins/#XPluginReceiveMessage
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFrom, int inMsg, void * /*inParam*/)
 {
-    // We only process one message: Did someone else wants to have TCAS control?
+    // Scenery reloaded? Then cached terrain heights are no longer valid
+    if (inMsg == XPLM_MSG_SCENERY_LOADED) {
+        TerrainCacheClear();
+        return;
+    }
+    
+    // Otherwise we only process one message: Did someone else wants to have TCAS control?
     if (inMsg != XPLM_MSG_RELEASE_PLANES)
         return;
 